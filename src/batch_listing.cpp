@@ -0,0 +1,140 @@
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+#include "batch_listing.hpp"
+#include "decode_memo.hpp"
+#include "listing_writer.hpp"
+#include "object_code_parser.hpp"
+#include "reverse_symbol_table.hpp"
+#include "symbol_table_parser.hpp"
+
+// Every file's new entries become a memo of their own, in front of the ones published before them. Once published, a
+// memo never changes, so a thread can hold on to the front of the chain and read it without locking.
+struct PublishedMemo
+{
+    std::mutex mutex;
+    std::shared_ptr<const DecodeMemo> front;
+    const DecodeMemo* base; // what the run started with, which stays at the back and is never copied
+};
+
+static bool listFile(const ListingInput& input, bool symbolic, bool verbose, const DecodeMemo* memo, DecodeMemo* newEntries)
+{
+    SymbolTableData symbolTableData {};
+
+    if (!parseSymbolTableFile(input.symbolFileName, symbolTableData))
+    {
+        printf("Failed to parse symbol table file! %s\n", input.symbolFileName.c_str());
+        return false;
+    }
+
+    ReverseSymbolTable reverseSymbols {};
+
+    if (symbolic)
+    {
+        int programStart {};
+        int programLength {};
+        parseHeaderRecord(input.objectFileName, programStart, programLength);
+        ReverseSymbolLookup::build(symbolTableData, programStart, programLength, reverseSymbols);
+    }
+
+    const DecoderContext context {&symbolTableData, verbose, symbolic ? &reverseSymbols : nullptr, memo};
+    ObjectCodeData objectCodeData {};
+
+    if (!parseObjectCodeFile(context, input.objectFileName, newEntries, objectCodeData))
+    {
+        printf("Failed to parse object code file! %s: %s\n", input.objectFileName.c_str(), objectCodeData.errorMessage.c_str());
+        return false;
+    }
+
+    if (!ListingWriter::write(input.listingFileName, objectCodeData))
+    {
+        printf("Failed to write listing file! %s\n", input.listingFileName.c_str());
+        return false;
+    }
+
+    return true;
+}
+
+static std::shared_ptr<const DecodeMemo> getFront(PublishedMemo& published)
+{
+    std::lock_guard<std::mutex> lock {published.mutex};
+    return published.front;
+}
+
+// Puts newEntries in front of the chain. A lookup walks the whole chain on a miss, so the new memo swallows the ones
+// behind it while they're no more than twice its size. That keeps every memo in the chain at least twice the size of
+// the one in front of it, i.e. the chain stays logarithmic in the number of entries.
+static void publish(PublishedMemo& published, const DecodeMemo& newEntries)
+{
+    auto memo = std::make_shared<DecodeMemo>();
+    memo->merge(newEntries);
+
+    std::lock_guard<std::mutex> lock {published.mutex};
+    std::shared_ptr<const DecodeMemo> next {published.front};
+
+    while (next.get() != published.base && next->getEntryCount() <= memo->getEntryCount() * 2)
+    {
+        memo->merge(*next);
+        next = next->getFallback();
+    }
+
+    memo->setFallback(next);
+    published.front = memo;
+}
+
+bool BatchListing::listFiles(const std::vector<ListingInput>& inputs, bool symbolic, bool verbose, unsigned threadCount, DecodeMemo* memo)
+{
+    threadCount = std::max(1u, std::min(threadCount, static_cast<unsigned>(inputs.size())));
+
+    // The caller's memo is only read until every thread is done, so it can sit at the back of the chain as it is.
+    PublishedMemo published {};
+    published.base = memo;
+
+    if (memo != nullptr)
+        published.front = std::shared_ptr<const DecodeMemo> {memo, [](const DecodeMemo*) {}};
+
+    std::atomic<size_t> nextInput {0};
+    std::atomic<bool> failed {false};
+
+    auto worker = [&]()
+    {
+        for (size_t i {nextInput++}; i < inputs.size(); i = nextInput++)
+        {
+            if (memo == nullptr)
+            {
+                if (!listFile(inputs[i], symbolic, verbose, nullptr, nullptr))
+                    failed = true;
+
+                continue;
+            }
+
+            // Whatever other threads finished before this file started gets shared with it.
+            std::shared_ptr<const DecodeMemo> shared {getFront(published)};
+            DecodeMemo newEntries {};
+
+            if (!listFile(inputs[i], symbolic, verbose, shared.get(), &newEntries))
+                failed = true;
+
+            publish(published, newEntries);
+        }
+    };
+
+    std::vector<std::thread> threads {};
+
+    for (unsigned i {1}; i < threadCount; ++i)
+        threads.emplace_back(worker);
+
+    worker();
+
+    for (std::thread& thread : threads)
+        thread.join();
+
+    for (const DecodeMemo* next {published.front.get()}; next != nullptr && next != memo; next = next->getFallback().get())
+        memo->merge(*next);
+
+    return !failed;
+}
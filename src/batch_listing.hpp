@@ -0,0 +1,26 @@
+// Listings for many object files in one run
+
+#ifndef ASSIG2_BATCH_LISTING_HPP
+#define ASSIG2_BATCH_LISTING_HPP
+
+#include <string>
+#include <vector>
+#include "types.hpp"
+
+struct ListingInput
+{
+    std::string objectFileName;
+    std::string symbolFileName;
+    std::string listingFileName;
+};
+
+namespace BatchListing
+{
+    // Decodes and writes every input, handing whole files out to threadCount threads. When memo is set, the records
+    // each file decodes are shared with every file started after it finishes, on any thread, and merged into memo at
+    // the end. Files that are decoded at the same time can't share with each other. Inputs that fail are reported and
+    // skipped.
+    bool listFiles(const std::vector<ListingInput>& inputs, bool symbolic, bool verbose, unsigned threadCount, DecodeMemo* memo);
+}
+
+#endif // ASSIG2_BATCH_LISTING_HPP
@@ -0,0 +1,520 @@
+#include <algorithm>
+#include <fstream>
+
+#include "logger.hpp"
+#include "decode_memo.hpp"
+#include "hashing.hpp"
+#include "instruction_definition_table.hpp"
+#include "string_parsing_tools.hpp"
+
+static const char MEMO_FILE_TAG[] {"DECODEMEMO3"};
+
+// Where the payload starts in a text record line.
+static const size_t PAYLOAD_COLUMN {9};
+
+// A CR from a windows line ending, or trailing spaces, shouldn't make an otherwise identical record miss.
+static size_t getRecordLength(const std::string& recordLine)
+{
+    size_t length {recordLine.size()};
+
+    while (length > 0 && (recordLine[length - 1] == '\r' || recordLine[length - 1] == ' ' || recordLine[length - 1] == '\t'))
+        length--;
+
+    return length;
+}
+
+template<typename T>
+static void appendValue(std::string& destination, T value)
+{
+    destination.append(reinterpret_cast<const char*>(&value), sizeof(value));
+}
+
+// Length prefixed, so consecutive strings can't run into each other.
+template<typename Length>
+static void appendString(std::string& destination, const char* data, size_t size)
+{
+    appendValue(destination, static_cast<Length>(size));
+    destination.append(data, size);
+}
+
+// Reads back what appendValue/appendString wrote, never going past end.
+struct SerializedReader
+{
+    const std::string& data;
+    size_t position;
+    size_t end;
+
+    template<typename T>
+    bool read(T& outValue)
+    {
+        if (end - position < sizeof(outValue))
+            return false;
+
+        data.copy(reinterpret_cast<char*>(&outValue), sizeof(outValue), position);
+        position += sizeof(outValue);
+        return true;
+    }
+
+    template<typename Length>
+    bool readString(std::string& outValue)
+    {
+        Length size {};
+
+        if (!read(size) || end - position < size)
+            return false;
+
+        outValue.assign(data, position, size);
+        position += size;
+        return true;
+    }
+};
+
+// The record line sits at the start of every key, after its length. Returns where it ends, and reads its address.
+static size_t getRecordEnd(const std::string& key, int& outStartAddress)
+{
+    u32 recordSize {};
+    key.copy(reinterpret_cast<char*>(&recordSize), sizeof(recordSize));
+    StringParsingTools::tryGetHexField(key, sizeof(recordSize) + 1, 6, outStartAddress);
+    return sizeof(recordSize) + recordSize;
+}
+
+// Where an instruction's object code starts within the key.
+static size_t getPayloadColumn(int address, int startAddress)
+{
+    return sizeof(u32) + PAYLOAD_COLUMN + static_cast<size_t>(address - startAddress) * 2;
+}
+
+// What the instruction column and decoded operand bits hold, which follow from the line's type and object code so they
+// don't need storing. Mirrors TextRecordWalker::walk and decodeTextRecord, insert() checks that they agree.
+static bool getInstruction(AssemblyLine::Type type, const std::string& key, size_t column, size_t objectCodeLength, std::string& outText,
+                           InstructionInfo& outInfo)
+{
+    outInfo = InstructionInfo {};
+
+    if (type == AssemblyLine::Type::Literal)
+    {
+        outText = "BYTE";
+        return true;
+    }
+
+    if (type == AssemblyLine::Type::Decoration)
+    {
+        outText = "BASE";
+        outInfo.shape = InstructionInfo::OperandShape::Base;
+        return true;
+    }
+
+    // Every opcode has its low two bits clear, format 3/4 keeps n and i there.
+    int firstByte {};
+
+    if (!StringParsingTools::tryGetHexField(key, column, 2, firstByte))
+        return false;
+
+    const InstructionDefinition* definition {InstructionDefinitionTable::find(static_cast<u8>(firstByte & 0xFC))};
+
+    if (definition == nullptr)
+        return false;
+
+    outText = definition->name;
+    outInfo.format = definition->format;
+    outInfo.shape = definition->shape;
+    outInfo.opcode = firstByte & 0xFC;
+
+    if (definition->format == InstructionInfo::Format::One)
+    {
+        return objectCodeLength == 2;
+    }
+    else if (definition->format == InstructionInfo::Format::Two)
+    {
+        int r1 {};
+        int r2 {};
+
+        if (objectCodeLength != 4 || !StringParsingTools::tryGetHexField(key, column + 2, 1, r1) || !StringParsingTools::tryGetHexField(key, column + 3, 1, r2))
+            return false;
+
+        outInfo.formatTwoInfo.r1 = static_cast<u8>(r1);
+        outInfo.formatTwoInfo.r2 = static_cast<u8>(r2);
+    }
+    else if (definition->format == InstructionInfo::Format::ThreeOrFour)
+    {
+        int flags {};
+        int field {};
+
+        if (objectCodeLength < 6 || !StringParsingTools::tryGetHexField(key, column + 2, 1, flags) || !StringParsingTools::tryGetHexField(key, column + 3, 3, field))
+            return false;
+
+        InstructionInfo::FormatThreeOrFourInfo& info = outInfo.formatThreeOrFourInfo;
+        info.n = (firstByte & 0b10) != 0;
+        info.i = (firstByte & 0b01) != 0;
+        info.x = (flags & 0b1000) != 0;
+        info.b = (flags & 0b0100) != 0;
+        info.p = (flags & 0b0010) != 0;
+        info.e = (flags & 0b0001) != 0;
+
+        if (objectCodeLength != (info.e ? 8u : 6u))
+            return false;
+
+        int lastByte {};
+
+        if (info.e && !info.b && !info.p)
+        {
+            if (!StringParsingTools::tryGetHexField(key, column + 6, 2, lastByte))
+                return false;
+
+            field = (field << 8) | lastByte;
+        }
+
+        info.addressField = field;
+
+        // Operands without a value are finished by the time a record is stored, the rest get their "+" when resolved.
+        if (info.e && definition->shape == InstructionInfo::OperandShape::None)
+            outText.insert(0, "+");
+    }
+
+    return true;
+}
+
+// Whether two decodes of the same object code agree on everything operand resolution reads.
+static bool isSameInstruction(const InstructionInfo& a, const InstructionInfo& b)
+{
+    if (a.format != b.format || a.shape != b.shape || a.opcode != b.opcode)
+        return false;
+
+    if (a.format == InstructionInfo::Format::Two)
+        return a.formatTwoInfo.r1 == b.formatTwoInfo.r1 && a.formatTwoInfo.r2 == b.formatTwoInfo.r2;
+
+    if (a.format == InstructionInfo::Format::ThreeOrFour)
+    {
+        const InstructionInfo::FormatThreeOrFourInfo& x = a.formatThreeOrFourInfo;
+        const InstructionInfo::FormatThreeOrFourInfo& y = b.formatThreeOrFourInfo;
+        return x.n == y.n && x.i == y.i && x.x == y.x && x.b == y.b && x.p == y.p && x.e == y.e && x.addressField == y.addressField;
+    }
+
+    return true;
+}
+
+DecodeMemo::DecodeMemo() :
+        m_data {},
+        m_offsets {},
+        m_fallback {},
+        m_hitCount {0},
+        m_missCount {0}
+{
+}
+
+void DecodeMemo::buildSymbols(const SymbolTableData& symbolData, DecodeMemoSymbols& outSymbols)
+{
+    outSymbols.symbols.clear();
+
+    for (u32 i {0}; i < symbolData.symbolCount; ++i)
+        outSymbols.symbols.push_back(&symbolData.symbols[i]);
+
+    std::stable_sort(outSymbols.symbols.begin(), outSymbols.symbols.end(), [](const Symbol* a, const Symbol* b) { return a->addressValue < b->addressValue; });
+
+    outSymbols.literals = symbolData.literals;
+    outSymbols.literalCount = symbolData.literalCount;
+}
+
+bool DecodeMemo::buildKey(const std::string& recordLine, const DecodeMemoSymbols& symbols, std::string& outKey)
+{
+    int startAddress {};
+    int length {};
+
+    if (!StringParsingTools::tryGetHexField(recordLine, 1, 6, startAddress) || !StringParsingTools::tryGetHexField(recordLine, 7, 2, length))
+        return false;
+
+    int endAddress {startAddress + length};
+
+    // The record line has to come first, find() reads the object code back out of it.
+    outKey.clear();
+    appendString<u32>(outKey, recordLine.data(), getRecordLength(recordLine));
+
+    // Labels, and the literals the record walks over.
+    auto firstSymbol = std::lower_bound(symbols.symbols.begin(), symbols.symbols.end(), startAddress,
+                                        [](const Symbol* symbol, int address) { return symbol->addressValue < address; });
+
+    for (auto it = firstSymbol; it != symbols.symbols.end() && (*it)->addressValue < endAddress; ++it)
+    {
+        appendValue(outKey, static_cast<s32>((*it)->addressValue));
+        appendString<u32>(outKey, (*it)->name.data(), (*it)->name.size());
+    }
+
+    // Symbols and literals both start with an address, so mark where one list ends.
+    appendValue(outKey, static_cast<s32>(NO_ADDRESS));
+
+    const Literal* literalsEnd {symbols.literals + symbols.literalCount};
+    const Literal* firstLiteral {std::lower_bound(symbols.literals, literalsEnd, startAddress,
+                                                  [](const Literal& literal, int address) { return literal.addressValue < address; })};
+
+    for (const Literal* literal {firstLiteral}; literal != literalsEnd && literal->addressValue < endAddress; ++literal)
+    {
+        appendValue(outKey, static_cast<s32>(literal->addressValue));
+        appendValue(outKey, static_cast<s32>(literal->lengthValue));
+        appendString<u32>(outKey, literal->name.data(), literal->name.size());
+        appendString<u32>(outKey, literal->value.data(), literal->value.size());
+    }
+
+    return true;
+}
+
+// Saved files are the tag and a checksum of the entries, followed by the entries exactly as they're kept in memory.
+// Each entry:
+//   u32 size of the rest of the entry, key, u32 line count
+// then per line:
+//   u8 type and object code length (type | length << 2), address text, label, value
+// Strings are prefixed with a u8 length. Everything else is rebuilt: the address from its text, the instruction and its
+// operand bits from the type and object code, and the object code from the record line at the start of the key (or a
+// literal's value, the same way it was decoded).
+bool DecodeMemo::find(const std::string& key, std::vector<AssemblyLine>& outLines) const
+{
+    auto result = m_offsets.find(Hashing::hashBytes(key.data(), key.size()));
+
+    if (result == m_offsets.end())
+        return m_fallback != nullptr && m_fallback->find(key, outLines);
+
+    u32 entrySize {};
+    SerializedReader reader {m_data, result->second, m_data.size()};
+    reader.read(entrySize);
+    reader.end = reader.position + entrySize;
+
+    u32 keySize {};
+
+    if (!reader.read(keySize) || keySize != key.size() || reader.end - reader.position < keySize ||
+        m_data.compare(reader.position, keySize, key) != 0)
+        return false;
+
+    reader.position += keySize;
+
+    int startAddress {};
+    size_t recordEnd {getRecordEnd(key, startAddress)};
+
+    u32 lineCount {};
+    size_t firstLine {outLines.size()};
+    bool valid {reader.read(lineCount)};
+
+    for (u32 i {0}; valid && i < lineCount; ++i)
+    {
+        outLines.emplace_back();
+        AssemblyLine& line = outLines.back();
+
+        u8 typeAndLength {};
+        int address {};
+
+        valid = reader.read(typeAndLength) && reader.readString<u8>(line.addressHex) && reader.readString<u8>(line.label) &&
+                reader.readString<u8>(line.value) && (typeAndLength & 3) <= static_cast<u8>(AssemblyLine::Type::Decoration) &&
+                (line.addressHex.empty() || StringParsingTools::tryGetHexField(line.addressHex, 0, line.addressHex.size(), address));
+
+        size_t objectCodeLength {static_cast<size_t>(typeAndLength >> 2)};
+        size_t column {getPayloadColumn(address, startAddress)};
+        line.type = static_cast<AssemblyLine::Type>(typeAndLength & 3);
+        line.addressValue = static_cast<size_t>(address);
+
+        if (line.type == AssemblyLine::Type::Instruction)
+        {
+            valid = valid && address >= startAddress && column + objectCodeLength <= recordEnd;
+
+            if (valid)
+                line.objectCode.assign(key, column, objectCodeLength);
+        }
+        else if (line.type == AssemblyLine::Type::Literal)
+        {
+            line.objectCode = StringParsingTools::getBetween(line.value, '\'');
+        }
+
+        valid = valid && getInstruction(line.type, key, column, objectCodeLength, line.instruction, line.instructionInfo);
+    }
+
+    // Only possible if a saved memo was damaged. Treat it like a miss so the record gets decoded instead.
+    if (!valid)
+    {
+        outLines.resize(firstLine);
+        return false;
+    }
+
+    return true;
+}
+
+void DecodeMemo::insert(const std::string& key, const AssemblyLine* lines, size_t count)
+{
+    u64 hash {Hashing::hashBytes(key.data(), key.size())};
+
+    if (m_offsets.count(hash) != 0)
+        return;
+
+    size_t offset {m_data.size()};
+    appendValue(m_data, static_cast<u32>(0));
+    appendString<u32>(m_data, key.data(), key.size());
+    appendValue(m_data, static_cast<u32>(count));
+
+    int startAddress {};
+    size_t recordEnd {getRecordEnd(key, startAddress)};
+    bool fits {true};
+
+    for (size_t i {0}; i < count; ++i)
+    {
+        const AssemblyLine& line = lines[i];
+        size_t column {getPayloadColumn(static_cast<int>(line.addressValue), startAddress)};
+        std::string instruction {};
+        InstructionInfo info {};
+
+        fits &= line.addressHex.size() <= UINT8_MAX && line.label.size() <= UINT8_MAX && line.value.size() <= UINT8_MAX &&
+                line.objectCode.size() <= UINT8_MAX >> 2;
+
+        // Only store what find() can rebuild exactly.
+        if (line.type == AssemblyLine::Type::Instruction)
+        {
+            fits &= static_cast<int>(line.addressValue) >= startAddress && column + line.objectCode.size() <= recordEnd &&
+                    key.compare(column, line.objectCode.size(), line.objectCode) == 0;
+        }
+        else
+        {
+            fits &= line.objectCode == (line.type == AssemblyLine::Type::Literal ? StringParsingTools::getBetween(line.value, '\'') : std::string {});
+        }
+
+        fits = fits && getInstruction(line.type, key, column, line.objectCode.size(), instruction, info) && instruction == line.instruction &&
+               isSameInstruction(info, line.instructionInfo);
+
+        appendValue(m_data, static_cast<u8>(static_cast<u8>(line.type) | line.objectCode.size() << 2));
+        appendString<u8>(m_data, line.addressHex.data(), line.addressHex.size());
+        appendString<u8>(m_data, line.label.data(), line.label.size());
+        appendString<u8>(m_data, line.value.data(), line.value.size());
+    }
+
+    // Anything that can't be stored this way is simply never remembered.
+    if (!fits)
+    {
+        m_data.resize(offset);
+        return;
+    }
+
+    u32 entrySize {static_cast<u32>(m_data.size() - offset - sizeof(u32))};
+    m_data.replace(offset, sizeof(entrySize), reinterpret_cast<const char*>(&entrySize), sizeof(entrySize));
+    m_offsets.emplace(hash, offset);
+}
+
+size_t DecodeMemo::addSerialized(const std::string& data, size_t offset)
+{
+    u32 entrySize {};
+    u32 keySize {};
+    SerializedReader reader {data, offset, data.size()};
+
+    if (!reader.read(entrySize) || data.size() - reader.position < entrySize)
+        return std::string::npos;
+
+    size_t next {reader.position + entrySize};
+    reader.end = next;
+
+    if (!reader.read(keySize) || reader.end - reader.position < keySize)
+        return std::string::npos;
+
+    u64 hash {Hashing::hashBytes(data.data() + reader.position, keySize)};
+
+    if (m_offsets.count(hash) == 0)
+    {
+        m_offsets.emplace(hash, m_data.size());
+        m_data.append(data, offset, next - offset);
+    }
+
+    return next;
+}
+
+void DecodeMemo::merge(const DecodeMemo& source)
+{
+    for (size_t offset {0}; offset < source.m_data.size();)
+        offset = addSerialized(source.m_data, offset);
+
+    m_hitCount += source.m_hitCount;
+    m_missCount += source.m_missCount;
+}
+
+void DecodeMemo::setFallback(const std::shared_ptr<const DecodeMemo>& fallback)
+{
+    m_fallback = fallback;
+}
+
+const std::shared_ptr<const DecodeMemo>& DecodeMemo::getFallback() const
+{
+    return m_fallback;
+}
+
+bool DecodeMemo::load(const std::string& fileName)
+{
+    std::ifstream memoStream {fileName, std::ios::binary | std::ios::ate};
+
+    if (!memoStream)
+        return true;
+
+    size_t fileSize {static_cast<size_t>(memoStream.tellg())};
+    memoStream.seekg(0);
+
+    char tag[sizeof(MEMO_FILE_TAG)] {};
+    u64 checksum {};
+
+    if (!memoStream.read(tag, sizeof(tag)) || std::string {tag} != MEMO_FILE_TAG || !memoStream.read(reinterpret_cast<char*>(&checksum), sizeof(checksum)))
+    {
+        Logger::log_warning("%s is not a decode memo", fileName.c_str());
+        return false;
+    }
+
+    std::string data(fileSize - sizeof(tag) - sizeof(checksum), '\0');
+
+    // A damaged entry could still decode into plausible lines, so the whole file has to check out before any of it is used.
+    if (!memoStream.read(&data[0], data.size()) || Hashing::hashBytes(data.data(), data.size()) != checksum)
+    {
+        Logger::log_warning("%s is damaged", fileName.c_str());
+        return false;
+    }
+
+    DecodeMemo loaded {};
+
+    for (size_t offset {0}; offset < data.size();)
+    {
+        offset = loaded.addSerialized(data, offset);
+
+        if (offset == std::string::npos)
+        {
+            Logger::log_warning("%s is damaged", fileName.c_str());
+            return false;
+        }
+    }
+
+    merge(loaded);
+    return true;
+}
+
+bool DecodeMemo::save(const std::string& fileName) const
+{
+    std::ofstream memoStream {fileName, std::ios::binary};
+
+    if (!memoStream)
+        return false;
+
+    u64 checksum {Hashing::hashBytes(m_data.data(), m_data.size())};
+    memoStream.write(MEMO_FILE_TAG, sizeof(MEMO_FILE_TAG));
+    memoStream.write(reinterpret_cast<const char*>(&checksum), sizeof(checksum));
+    memoStream.write(m_data.data(), m_data.size());
+    return static_cast<bool>(memoStream);
+}
+
+void DecodeMemo::countLookup(bool hit)
+{
+    if (hit)
+        m_hitCount++;
+    else
+        m_missCount++;
+}
+
+size_t DecodeMemo::getEntryCount() const
+{
+    return m_offsets.size();
+}
+
+u64 DecodeMemo::getHitCount() const
+{
+    return m_hitCount;
+}
+
+u64 DecodeMemo::getMissCount() const
+{
+    return m_missCount;
+}
@@ -0,0 +1,89 @@
+// Memo of decoded text records, shared between files
+
+#ifndef ASSIG2_DECODE_MEMO_HPP
+#define ASSIG2_DECODE_MEMO_HPP
+
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "types.hpp"
+
+// The parts of a symbol table that can end up in a text record's lines, sorted by address so a key only has to look
+// at what falls inside its record. Built once per symbol table.
+struct DecodeMemoSymbols
+{
+    std::vector<const Symbol*> symbols; // stable sorted, so the last of a run is the one the label column shows
+
+    // The symbol table's own literals, which the parser already sorted.
+    const Literal* literals;
+    u32 literalCount;
+};
+
+// Remembers the lines each text record decoded into, so a record that comes up again (later in the same corpus, or in
+// an earlier run when the memo is saved) is copied instead of decoded.
+//
+// Lines are remembered before the operands that depend on the registers are resolved, i.e. format 3/4 addresses and
+// the BASE line. Those still get resolved on every hit, so the key only needs what decoding itself depends on: the
+// record (which includes its address), and the labels and literals inside it. A record is reused whatever came before
+// it and whatever symbols its operands point at. The whole key is compared on every hit, so a hash collision can only
+// cost a miss.
+//
+// Entries are kept serialized the same way they're saved, so loading a memo is a single read plus indexing, and only
+// the records that actually come up again are turned back into lines.
+//
+// Not locked. While decoding, a memo shared between threads is only ever read, and each thread adds what it decodes to
+// its own memo. A memo can fall back to another one, so a thread's finished entries can be put in front of the shared
+// memo as a new memo of their own instead of changing it.
+class DecodeMemo
+{
+public:
+    DecodeMemo();
+
+    DecodeMemo(const DecodeMemo&) = delete;
+    DecodeMemo& operator=(const DecodeMemo&) = delete;
+
+    static void buildSymbols(const SymbolTableData& symbolData, DecodeMemoSymbols& outSymbols);
+
+    // Builds the key for a text record line. False if the record's address or length can't be read, in which case
+    // decoding it will report the error.
+    static bool buildKey(const std::string& recordLine, const DecodeMemoSymbols& symbols, std::string& outKey);
+
+    // Appends the lines remembered for the key (here or in the fallback), as they were before the register dependent
+    // operands were resolved. False if the record hasn't been seen before.
+    bool find(const std::string& key, std::vector<AssemblyLine>& outLines) const;
+
+    // Remembers lines[0, count) for the key. Does nothing if there's already an entry with the same hash.
+    void insert(const std::string& key, const AssemblyLine* lines, size_t count);
+
+    // Copies every entry of source (but not of its fallback) that isn't already here, along with its hit and miss counts.
+    void merge(const DecodeMemo& source);
+
+    // Where find() looks when a key isn't here. Has to be set before the memo is shared.
+    void setFallback(const std::shared_ptr<const DecodeMemo>& fallback);
+    const std::shared_ptr<const DecodeMemo>& getFallback() const;
+
+    // Merges in the entries of a saved memo. A missing file is not an error, it just means a cold start.
+    bool load(const std::string& fileName);
+    bool save(const std::string& fileName) const;
+
+    // Lookups are counted on the memo that misses get inserted into.
+    void countLookup(bool hit);
+
+    // Entries held here, not counting the fallback.
+    size_t getEntryCount() const;
+    u64 getHitCount() const;
+    u64 getMissCount() const;
+
+private:
+    // Appends the entry that starts at data[offset] if its key isn't here yet. Returns where the next one starts.
+    size_t addSerialized(const std::string& data, size_t offset);
+
+    std::string m_data;
+    std::unordered_map<u64, size_t> m_offsets; // hash of each entry's key to where the entry starts in m_data
+    std::shared_ptr<const DecodeMemo> m_fallback;
+    u64 m_hitCount;
+    u64 m_missCount;
+};
+
+#endif // ASSIG2_DECODE_MEMO_HPP
@@ -0,0 +1,61 @@
+// Small non-cryptographic hashes for cache keys and staleness checks
+
+#ifndef ASSIG2_HASHING_HPP
+#define ASSIG2_HASHING_HPP
+
+#include <string>
+#include "types.hpp"
+
+// 64-bit FNV-1a. Fast enough for the short inputs it's used on, and good enough to tell versions apart.
+namespace Hashing
+{
+    static const u64 OFFSET_BASIS {0xCBF29CE484222325ull};
+    static const u64 PRIME {0x100000001B3ull};
+
+    inline u64 hashBytes(const void* data, size_t size, u64 hash = OFFSET_BASIS)
+    {
+        const u8* bytes {static_cast<const u8*>(data)};
+
+        for (size_t i {0}; i < size; ++i)
+            hash = (hash ^ bytes[i]) * PRIME;
+
+        return hash;
+    }
+
+    // Includes the length, so consecutive strings can't run into each other.
+    inline u64 hashString(const std::string& value, u64 hash = OFFSET_BASIS)
+    {
+        u64 size {value.size()};
+        hash = hashBytes(&size, sizeof(size), hash);
+        return hashBytes(value.data(), value.size(), hash);
+    }
+
+    inline u64 hashInt(s64 value, u64 hash = OFFSET_BASIS)
+    {
+        return hashBytes(&value, sizeof(value), hash);
+    }
+
+    // Everything the decoder takes from a symbol table: names and addresses, and the literals' values and lengths.
+    inline u64 hashSymbolTable(const SymbolTableData& symbolData)
+    {
+        u64 hash {OFFSET_BASIS};
+
+        for (u32 i {0}; i < symbolData.symbolCount; ++i)
+        {
+            hash = hashString(symbolData.symbols[i].name, hash);
+            hash = hashInt(symbolData.symbols[i].addressValue, hash);
+        }
+
+        for (u32 i {0}; i < symbolData.literalCount; ++i)
+        {
+            hash = hashString(symbolData.literals[i].name, hash);
+            hash = hashString(symbolData.literals[i].value, hash);
+            hash = hashInt(symbolData.literals[i].addressValue, hash);
+            hash = hashInt(symbolData.literals[i].lengthValue, hash);
+        }
+
+        return hash;
+    }
+}
+
+#endif // ASSIG2_HASHING_HPP
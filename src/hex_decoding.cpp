@@ -0,0 +1,207 @@
+#include <cstdlib>
+#include <cstring>
+
+#include "hex_decoding.hpp"
+
+#if defined(__x86_64__) && defined(__GNUC__)
+#define ASSIG2_HEX_DECODING_X86
+#include <immintrin.h>
+#endif
+
+typedef size_t (*DecodeFunction)(const char* text, size_t length, u8* outBytes);
+
+static const u8 INVALID_NIBBLE {0xFF};
+
+// Maps every character to its hex value, or INVALID_NIBBLE.
+struct NibbleTable
+{
+    u8 values[256];
+
+    NibbleTable() : values {}
+    {
+        for (int i {0}; i < 256; ++i)
+            values[i] = INVALID_NIBBLE;
+
+        for (int i {0}; i < 10; ++i)
+            values['0' + i] = static_cast<u8>(i);
+
+        for (int i {0}; i < 6; ++i)
+        {
+            values['A' + i] = static_cast<u8>(10 + i);
+            values['a' + i] = static_cast<u8>(10 + i);
+        }
+    }
+};
+
+static const NibbleTable s_nibbleTable {};
+
+static size_t decodeScalar(const char* text, size_t length, u8* outBytes)
+{
+    for (size_t i {0}; i < length; i += 2)
+    {
+        u8 high {s_nibbleTable.values[static_cast<u8>(text[i])]};
+        u8 low {s_nibbleTable.values[static_cast<u8>(text[i + 1])]};
+
+        if (high == INVALID_NIBBLE)
+            return i;
+
+        if (low == INVALID_NIBBLE)
+            return i + 1;
+
+        outBytes[i / 2] = static_cast<u8>((high << 4) | low);
+    }
+
+    return HexDecoding::ALL_VALID;
+}
+
+#ifdef ASSIG2_HEX_DECODING_X86
+
+// Turns 16 characters into their nibble values, and marks which of them were valid hex digits.
+// Folding with 0x20 lower-cases A-F without letting anything else fold into a-f; digits are checked unfolded.
+static inline __m128i getNibblesSse2(__m128i text, __m128i& outValid)
+{
+    __m128i folded {_mm_or_si128(text, _mm_set1_epi8(0x20))};
+    __m128i isDigit {_mm_and_si128(_mm_cmpgt_epi8(text, _mm_set1_epi8('0' - 1)), _mm_cmplt_epi8(text, _mm_set1_epi8('9' + 1)))};
+    __m128i isLetter {_mm_and_si128(_mm_cmpgt_epi8(folded, _mm_set1_epi8('a' - 1)), _mm_cmplt_epi8(folded, _mm_set1_epi8('f' + 1)))};
+    outValid = _mm_or_si128(isDigit, isLetter);
+
+    __m128i digitValues {_mm_and_si128(isDigit, _mm_sub_epi8(text, _mm_set1_epi8('0')))};
+    __m128i letterValues {_mm_and_si128(isLetter, _mm_sub_epi8(folded, _mm_set1_epi8('a' - 10)))};
+    return _mm_or_si128(digitValues, letterValues);
+}
+
+// Each 16-bit lane holds a pair of nibbles (first character in the low byte), combine them into one byte per lane.
+static inline __m128i combineNibblesSse2(__m128i nibbles)
+{
+    __m128i high {_mm_slli_epi16(_mm_and_si128(nibbles, _mm_set1_epi16(0x00FF)), 4)};
+    __m128i low {_mm_srli_epi16(nibbles, 8)};
+    return _mm_or_si128(high, low);
+}
+
+static inline size_t getFirstInvalid(int validMask, int fullMask)
+{
+    return static_cast<size_t>(__builtin_ctz(static_cast<unsigned>(~validMask & fullMask)));
+}
+
+static size_t decodeSse2(const char* text, size_t length, u8* outBytes)
+{
+    size_t i {0};
+
+    for (; i + 32 <= length; i += 32)
+    {
+        __m128i valid0 {};
+        __m128i valid1 {};
+        __m128i nibbles0 {getNibblesSse2(_mm_loadu_si128(reinterpret_cast<const __m128i*>(text + i)), valid0)};
+        __m128i nibbles1 {getNibblesSse2(_mm_loadu_si128(reinterpret_cast<const __m128i*>(text + i + 16)), valid1)};
+
+        int validMask {_mm_movemask_epi8(valid0) | (_mm_movemask_epi8(valid1) << 16)};
+
+        if (validMask != -1)
+            return i + getFirstInvalid(validMask, -1);
+
+        __m128i bytes {_mm_packus_epi16(combineNibblesSse2(nibbles0), combineNibblesSse2(nibbles1))};
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(outBytes + i / 2), bytes);
+    }
+
+    size_t tail {decodeScalar(text + i, length - i, outBytes + i / 2)};
+    return tail == HexDecoding::ALL_VALID ? tail : i + tail;
+}
+
+__attribute__((target("avx2")))
+static inline __m256i getNibblesAvx2(__m256i text, __m256i& outValid)
+{
+    __m256i folded {_mm256_or_si256(text, _mm256_set1_epi8(0x20))};
+    __m256i isDigit {_mm256_and_si256(_mm256_cmpgt_epi8(text, _mm256_set1_epi8('0' - 1)), _mm256_cmpgt_epi8(_mm256_set1_epi8('9' + 1), text))};
+    __m256i isLetter {_mm256_and_si256(_mm256_cmpgt_epi8(folded, _mm256_set1_epi8('a' - 1)), _mm256_cmpgt_epi8(_mm256_set1_epi8('f' + 1), folded))};
+    outValid = _mm256_or_si256(isDigit, isLetter);
+
+    __m256i digitValues {_mm256_and_si256(isDigit, _mm256_sub_epi8(text, _mm256_set1_epi8('0')))};
+    __m256i letterValues {_mm256_and_si256(isLetter, _mm256_sub_epi8(folded, _mm256_set1_epi8('a' - 10)))};
+    return _mm256_or_si256(digitValues, letterValues);
+}
+
+__attribute__((target("avx2")))
+static inline __m256i combineNibblesAvx2(__m256i nibbles)
+{
+    __m256i high {_mm256_slli_epi16(_mm256_and_si256(nibbles, _mm256_set1_epi16(0x00FF)), 4)};
+    __m256i low {_mm256_srli_epi16(nibbles, 8)};
+    return _mm256_or_si256(high, low);
+}
+
+__attribute__((target("avx2")))
+static size_t decodeAvx2(const char* text, size_t length, u8* outBytes)
+{
+    size_t i {0};
+
+    for (; i + 64 <= length; i += 64)
+    {
+        __m256i valid0 {};
+        __m256i valid1 {};
+        __m256i nibbles0 {getNibblesAvx2(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(text + i)), valid0)};
+        __m256i nibbles1 {getNibblesAvx2(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(text + i + 32)), valid1)};
+
+        int validMask0 {_mm256_movemask_epi8(valid0)};
+        int validMask1 {_mm256_movemask_epi8(valid1)};
+
+        if (validMask0 != -1)
+            return i + getFirstInvalid(validMask0, -1);
+
+        if (validMask1 != -1)
+            return i + 32 + getFirstInvalid(validMask1, -1);
+
+        // packus works within each 128-bit lane, so put the quadwords back in order afterwards.
+        __m256i bytes {_mm256_packus_epi16(combineNibblesAvx2(nibbles0), combineNibblesAvx2(nibbles1))};
+        bytes = _mm256_permute4x64_epi64(bytes, _MM_SHUFFLE(3, 1, 2, 0));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(outBytes + i / 2), bytes);
+    }
+
+    // Whatever is left is less than one AVX2 step, which SSE2 can still chew through.
+    size_t tail {decodeSse2(text + i, length - i, outBytes + i / 2)};
+    return tail == HexDecoding::ALL_VALID ? tail : i + tail;
+}
+
+#endif // ASSIG2_HEX_DECODING_X86
+
+struct Implementation
+{
+    DecodeFunction function;
+    const char* name;
+};
+
+static Implementation selectImplementation()
+{
+    // Lets the sample checks run every kernel on one machine. Asking for one the CPU lacks gets the best it has.
+    const char* requested {getenv("ASSIG2_HEX_DECODER")};
+
+    if (requested != nullptr && strcmp(requested, "scalar") == 0)
+        return {decodeScalar, "scalar"};
+
+#ifdef ASSIG2_HEX_DECODING_X86
+    __builtin_cpu_init();
+    bool allowAvx2 {requested == nullptr || strcmp(requested, "sse2") != 0};
+
+    if (allowAvx2 && __builtin_cpu_supports("avx2"))
+        return {decodeAvx2, "avx2"};
+
+    if (__builtin_cpu_supports("sse2"))
+        return {decodeSse2, "sse2"};
+#endif
+
+    return {decodeScalar, "scalar"};
+}
+
+static const Implementation& getImplementation()
+{
+    static const Implementation implementation {selectImplementation()};
+    return implementation;
+}
+
+size_t HexDecoding::decode(const char* text, size_t length, u8* outBytes)
+{
+    return getImplementation().function(text, length, outBytes);
+}
+
+const char* HexDecoding::getImplementationName()
+{
+    return getImplementation().name;
+}
@@ -0,0 +1,24 @@
+// Validating hex to byte conversion
+
+#ifndef ASSIG2_HEX_DECODING_HPP
+#define ASSIG2_HEX_DECODING_HPP
+
+#include <cstddef>
+#include "types.hpp"
+
+// Converts whole runs of hex text into bytes, validating every character on the way. Uses AVX2 or SSE2 when the
+// CPU supports them (checked once at runtime), and a table-driven scalar loop otherwise. Setting ASSIG2_HEX_DECODER
+// to scalar, sse2, or avx2 picks one explicitly, which is how the samples get checked against every kernel.
+namespace HexDecoding
+{
+    static const size_t ALL_VALID {static_cast<size_t>(-1)};
+
+    // Decodes length characters (which must be even) into length / 2 bytes. Returns the index of the first
+    // character that isn't a hex digit, or ALL_VALID. On failure the contents of outBytes are unspecified.
+    size_t decode(const char* text, size_t length, u8* outBytes);
+
+    // Which implementation decode() picked, e.g. for logging.
+    const char* getImplementationName();
+}
+
+#endif // ASSIG2_HEX_DECODING_HPP
@@ -13,17 +13,22 @@
 // Information about an instructions name and format, keyed to an opcode number in the table.
 struct InstructionDefinition
 {
-    InstructionDefinition(std::string name, InstructionInfo::Format format);
+    InstructionDefinition(std::string name, InstructionInfo::Format format, InstructionInfo::OperandShape shape);
     InstructionDefinition();
 
     std::string name;
     InstructionInfo::Format format;
+    InstructionInfo::OperandShape shape;
 };
 
 namespace InstructionDefinitionTable
 {
+    // Unknown opcodes give back an empty definition. The table itself is never modified, so lookups are thread-safe.
     InstructionDefinition get(u8 opcode);
     bool contains(u8 opcode);
+
+    // Looks up a definition without copying it, returning nullptr for unknown opcodes.
+    const InstructionDefinition* find(u8 opcode);
 }
 
 #endif // ASSIG2_INSTRUCTION_DEFINITION_TABLE_HPP
\ No newline at end of file
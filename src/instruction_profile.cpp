@@ -0,0 +1,264 @@
+#include <algorithm>
+#include <atomic>
+#include <fstream>
+#include <thread>
+
+#include "logger.hpp"
+#include "line_reader.hpp"
+#include "instruction_definition_table.hpp"
+#include "instruction_profile.hpp"
+#include "symbol_table_parser.hpp"
+#include "text_record_walker.hpp"
+
+static const u64 CHUNK_SIZE_BYTES {4 * 1024 * 1024};
+
+// A slice of one input file. Lines belong to the chunk their first character falls in.
+struct ProfileChunk
+{
+    size_t inputIndex;
+    u64 start;
+    u64 end;
+};
+
+static bool profileChunk(const ProfileInput& input, const SymbolTableData& symbolData, const ProfileChunk& chunk, InstructionProfile& profile)
+{
+    LineReader objectCodeReader {input.objectFileName};
+    std::string line {};
+    u64 offset {chunk.start};
+
+    // Unless we start at the beginning, the line we land in belongs to the previous chunk, so skip past it.
+    if (chunk.start > 0)
+    {
+        objectCodeReader.seek(chunk.start - 1);
+        objectCodeReader.getLine(line);
+        offset += line.size();
+    }
+
+    auto countInstruction = [&](const WalkedInstruction& instruction) -> bool
+    {
+        if (instruction.isLiteral)
+        {
+            profile.literalCount++;
+            return true;
+        }
+
+        profile.opcodeCounts[instruction.opcode]++;
+        profile.formatCounts[static_cast<int>(instruction.format)]++;
+
+        if (instruction.format == InstructionInfo::Format::ThreeOrFour)
+            profile.nixbpeCounts[instruction.nixbpe]++;
+
+        return true;
+    };
+
+    TextRecord record {};
+    std::string error {};
+
+    while (offset < chunk.end && objectCodeReader.getLine(line))
+    {
+        u64 lineOffset {offset};
+        offset += line.size() + 1;
+
+        if (line.empty() || line[0] != 'T')
+            continue;
+
+        profile.textRecordCount++;
+
+        // The offset is where the line starts (in the decompressed data, for compressed files), the error has the column.
+        if (!TextRecordWalker::parse(line, record, error) || !TextRecordWalker::walk(record, symbolData, NO_ADDRESS, countInstruction, &error))
+        {
+            Logger::log_warning("%s: offset %llu: %s", input.objectFileName.c_str(), (unsigned long long) lineOffset, error.c_str());
+            profile.failedRecordCount++;
+        }
+    }
+
+    if (objectCodeReader.failed())
+    {
+        Logger::log_error("failed to read %s", input.objectFileName.c_str());
+        return false;
+    }
+
+    return true;
+}
+
+bool InstructionProfiling::profileFiles(const std::vector<ProfileInput>& inputs, unsigned threadCount, InstructionProfile& outProfile)
+{
+    std::vector<SymbolTableData> symbolTables(inputs.size());
+    std::vector<ProfileChunk> chunks {};
+
+    for (size_t i {0}; i < inputs.size(); ++i)
+    {
+        std::ifstream objectCodeStream {inputs[i].objectFileName, std::ios::binary | std::ios::ate};
+
+        if (!objectCodeStream)
+        {
+            Logger::log_error("could not open %s", inputs[i].objectFileName.c_str());
+            return false;
+        }
+
+        if (!parseSymbolTableFile(inputs[i].symbolFileName, symbolTables[i]))
+        {
+            Logger::log_error("could not read %s", inputs[i].symbolFileName.c_str());
+            return false;
+        }
+
+        u64 fileSize {static_cast<u64>(objectCodeStream.tellg())};
+
+        // Compressed files can't be split up, so they are streamed start to finish by a single thread.
+        if (LineReader::detectCompression(inputs[i].objectFileName) != LineReader::Compression::None)
+        {
+            chunks.push_back({i, 0, UINT64_MAX});
+            continue;
+        }
+
+        for (u64 start {0}; start < fileSize; start += CHUNK_SIZE_BYTES)
+            chunks.push_back({i, start, std::min(start + CHUNK_SIZE_BYTES, fileSize)});
+    }
+
+    threadCount = std::max(1u, std::min(threadCount, static_cast<unsigned>(chunks.size())));
+
+    // Each thread pulls chunks off a shared counter and only ever touches its own profile.
+    std::vector<InstructionProfile> threadProfiles(threadCount, InstructionProfile {});
+    std::atomic<size_t> nextChunk {0};
+    std::atomic<bool> failed {false};
+
+    auto worker = [&](unsigned threadIndex)
+    {
+        for (size_t i {nextChunk++}; i < chunks.size(); i = nextChunk++)
+        {
+            const ProfileChunk& chunk = chunks[i];
+
+            if (!profileChunk(inputs[chunk.inputIndex], symbolTables[chunk.inputIndex], chunk, threadProfiles[threadIndex]))
+                failed = true;
+        }
+    };
+
+    std::vector<std::thread> threads {};
+
+    for (unsigned i {1}; i < threadCount; ++i)
+        threads.emplace_back(worker, i);
+
+    worker(0);
+
+    for (std::thread& thread : threads)
+        thread.join();
+
+    outProfile = InstructionProfile {};
+
+    for (const InstructionProfile& profile : threadProfiles)
+        merge(profile, outProfile);
+
+    return !failed;
+}
+
+void InstructionProfiling::merge(const InstructionProfile& source, InstructionProfile& destination)
+{
+    for (int i {0}; i < 256; ++i)
+        destination.opcodeCounts[i] += source.opcodeCounts[i];
+
+    for (int i {0}; i < 64; ++i)
+        destination.nixbpeCounts[i] += source.nixbpeCounts[i];
+
+    for (int i {0}; i < 3; ++i)
+        destination.formatCounts[i] += source.formatCounts[i];
+
+    destination.literalCount += source.literalCount;
+    destination.textRecordCount += source.textRecordCount;
+    destination.failedRecordCount += source.failedRecordCount;
+}
+
+static double getPercent(u64 count, u64 total)
+{
+    return total == 0 ? 0.0 : 100.0 * static_cast<double>(count) / static_cast<double>(total);
+}
+
+// Sums the format 3/4 counters for every nixbpe combination that has all the bits in mask set to value.
+static u64 countAddressingMode(const InstructionProfile& profile, int mask, int value)
+{
+    u64 result {};
+
+    for (int i {0}; i < 64; ++i)
+    {
+        if ((i & mask) == value)
+            result += profile.nixbpeCounts[i];
+    }
+
+    return result;
+}
+
+void InstructionProfiling::printReport(const InstructionProfile& profile, FILE* stream)
+{
+    u64 instructionCount {profile.formatCounts[0] + profile.formatCounts[1] + profile.formatCounts[2]};
+    u64 formatThreeOrFourCount {profile.formatCounts[static_cast<int>(InstructionInfo::Format::ThreeOrFour)]};
+
+    fprintf(stream, "Text records: %llu (%llu could not be decoded)\n", (unsigned long long) profile.textRecordCount, (unsigned long long) profile.failedRecordCount);
+    fprintf(stream, "Instructions: %llu\n", (unsigned long long) instructionCount);
+    fprintf(stream, "Literals:     %llu\n\n", (unsigned long long) profile.literalCount);
+
+    fprintf(stream, "Formats:\n");
+    fprintf(stream, "  %-12s %12llu %6.2f%%\n", "1", (unsigned long long) profile.formatCounts[0], getPercent(profile.formatCounts[0], instructionCount));
+    fprintf(stream, "  %-12s %12llu %6.2f%%\n", "2", (unsigned long long) profile.formatCounts[1], getPercent(profile.formatCounts[1], instructionCount));
+    fprintf(stream, "  %-12s %12llu %6.2f%%\n\n", "3/4", (unsigned long long) profile.formatCounts[2], getPercent(profile.formatCounts[2], instructionCount));
+
+    // Most used opcodes first.
+    std::vector<int> opcodes {};
+
+    for (int i {0}; i < 256; ++i)
+    {
+        if (profile.opcodeCounts[i] != 0)
+            opcodes.push_back(i);
+    }
+
+    std::stable_sort(opcodes.begin(), opcodes.end(), [&](int a, int b) { return profile.opcodeCounts[a] > profile.opcodeCounts[b]; });
+
+    fprintf(stream, "Opcodes:\n");
+
+    for (int opcode : opcodes)
+    {
+        const InstructionDefinition* definition {InstructionDefinitionTable::find(static_cast<u8>(opcode))};
+        fprintf(stream, "  %02X %-9s %12llu %6.2f%%\n", opcode, definition != nullptr ? definition->name.c_str() : "?",
+                (unsigned long long) profile.opcodeCounts[opcode], getPercent(profile.opcodeCounts[opcode], instructionCount));
+    }
+
+    struct AddressingMode
+    {
+        const char* name;
+        int mask;
+        int value;
+    };
+
+    static const AddressingMode modes[] {
+            {"simple", 0b110000, 0b110000},
+            {"immediate #", 0b110000, 0b010000},
+            {"indirect @", 0b110000, 0b100000},
+            {"sic", 0b110000, 0b000000},
+            {"indexed", 0b001000, 0b001000},
+            {"base-rel", 0b000110, 0b000100},
+            {"pc-rel", 0b000110, 0b000010},
+            {"direct", 0b000110, 0b000000},
+            {"extended +", 0b000001, 0b000001},
+    };
+
+    fprintf(stream, "\nAddressing modes (format 3/4):\n");
+
+    for (const AddressingMode& mode : modes)
+    {
+        u64 count {countAddressingMode(profile, mode.mask, mode.value)};
+        fprintf(stream, "  %-12s %12llu %6.2f%%\n", mode.name, (unsigned long long) count, getPercent(count, formatThreeOrFourCount));
+    }
+
+    fprintf(stream, "\nnixbpe combinations:\n");
+
+    for (int i {0}; i < 64; ++i)
+    {
+        if (profile.nixbpeCounts[i] == 0)
+            continue;
+
+        char bits[7] {};
+
+        for (int bit {0}; bit < 6; ++bit)
+            bits[bit] = (i & (0b100000 >> bit)) ? '1' : '0';
+
+        fprintf(stream, "  %-12s %12llu %6.2f%%\n", bits, (unsigned long long) profile.nixbpeCounts[i], getPercent(profile.nixbpeCounts[i], formatThreeOrFourCount));
+    }
+}
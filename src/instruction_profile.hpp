@@ -0,0 +1,39 @@
+// Instruction-mix and addressing-mode profiling
+
+#ifndef ASSIG2_INSTRUCTION_PROFILE_HPP
+#define ASSIG2_INSTRUCTION_PROFILE_HPP
+
+#include <cstdio>
+#include <string>
+#include <vector>
+#include "types.hpp"
+
+// Counters gathered straight from the walker, without rendering any listing text.
+struct InstructionProfile
+{
+    u64 opcodeCounts[256];
+    u64 nixbpeCounts[64];   // indexed by the packed nixbpe bits of format 3/4 instructions
+    u64 formatCounts[3];    // indexed by InstructionInfo::Format
+    u64 literalCount;
+    u64 textRecordCount;
+    u64 failedRecordCount;  // text records that contained an unknown opcode or malformed hex
+};
+
+struct ProfileInput
+{
+    std::string objectFileName;
+    std::string symbolFileName;
+};
+
+namespace InstructionProfiling
+{
+    // Splits every input into chunks of lines and profiles them on threadCount threads, each with its own
+    // counters that get merged at the end. False if any input couldn't be opened or read to the end, since the
+    // counts would then be missing part of it.
+    bool profileFiles(const std::vector<ProfileInput>& inputs, unsigned threadCount, InstructionProfile& outProfile);
+
+    void merge(const InstructionProfile& source, InstructionProfile& destination);
+    void printReport(const InstructionProfile& profile, FILE* stream);
+}
+
+#endif // ASSIG2_INSTRUCTION_PROFILE_HPP
@@ -0,0 +1,278 @@
+#include <cstring>
+
+#ifdef ASSIG2_HAVE_ZLIB
+#include <zlib.h>
+#endif
+
+#ifdef ASSIG2_HAVE_ZSTD
+#include <zstd.h>
+#endif
+
+#include "logger.hpp"
+#include "line_reader.hpp"
+
+static const size_t INPUT_CHUNK_SIZE {64 * 1024};
+static const size_t BUFFER_CHUNK_SIZE {256 * 1024};
+
+static LineReader::Compression detectCompression(FILE* file)
+{
+    unsigned char magic[4] {};
+    size_t magicSize {fread(magic, 1, sizeof(magic), file)};
+    fseeko(file, 0, SEEK_SET);
+
+    if (magicSize >= 2 && magic[0] == 0x1F && magic[1] == 0x8B)
+        return LineReader::Compression::Gzip;
+
+    if (magicSize >= 4 && magic[0] == 0x28 && magic[1] == 0xB5 && magic[2] == 0x2F && magic[3] == 0xFD)
+        return LineReader::Compression::Zstd;
+
+    return LineReader::Compression::None;
+}
+
+LineReader::LineReader(const std::string& fileName) :
+        m_file {fopen(fileName.c_str(), "rb")},
+        m_compression {Compression::None},
+        m_failed {false},
+        m_inputFinished {false},
+        m_frameOpen {false},
+        m_input {},
+        m_inputPosition {},
+        m_inputSize {},
+        m_buffer(BUFFER_CHUNK_SIZE),
+        m_bufferPosition {},
+        m_bufferSize {},
+        m_decoder {nullptr}
+{
+    if (m_file == nullptr)
+        return;
+
+    m_compression = ::detectCompression(m_file);
+
+    if (m_compression == Compression::Gzip)
+    {
+#ifdef ASSIG2_HAVE_ZLIB
+        auto* stream = new z_stream {};
+
+        // 32 lets zlib parse the gzip header itself.
+        if (inflateInit2(stream, 15 + 32) != Z_OK)
+        {
+            delete stream;
+            m_failed = true;
+            return;
+        }
+
+        m_decoder = stream;
+#else
+        Logger::log_error("%s is gzip compressed, but this build has no zlib support", fileName.c_str());
+        m_failed = true;
+#endif
+    }
+    else if (m_compression == Compression::Zstd)
+    {
+#ifdef ASSIG2_HAVE_ZSTD
+        m_decoder = ZSTD_createDStream();
+        m_failed = m_decoder == nullptr;
+#else
+        Logger::log_error("%s is zstd compressed, but this build has no zstd support", fileName.c_str());
+        m_failed = true;
+#endif
+    }
+
+    if (m_compression != Compression::None)
+        m_input.resize(INPUT_CHUNK_SIZE);
+}
+
+LineReader::~LineReader()
+{
+#ifdef ASSIG2_HAVE_ZLIB
+    if (m_compression == Compression::Gzip && m_decoder != nullptr)
+    {
+        auto* stream = static_cast<z_stream*>(m_decoder);
+        inflateEnd(stream);
+        delete stream;
+    }
+#endif
+
+#ifdef ASSIG2_HAVE_ZSTD
+    if (m_compression == Compression::Zstd && m_decoder != nullptr)
+        ZSTD_freeDStream(static_cast<ZSTD_DStream*>(m_decoder));
+#endif
+
+    if (m_file != nullptr)
+        fclose(m_file);
+}
+
+bool LineReader::getLine(std::string& outLine)
+{
+    outLine.clear();
+    bool readAnything {false};
+
+    while (true)
+    {
+        // A line cut short by a decompression error isn't a line, so the caller sees the failure instead.
+        if (m_bufferPosition == m_bufferSize && !fill())
+            return readAnything && !m_failed;
+
+        readAnything = true;
+        const char* start {m_buffer.data() + m_bufferPosition};
+        size_t available {m_bufferSize - m_bufferPosition};
+        auto* newline = static_cast<const char*>(memchr(start, '\n', available));
+
+        if (newline != nullptr)
+        {
+            outLine.append(start, newline - start);
+            m_bufferPosition += (newline - start) + 1;
+            return true;
+        }
+
+        // The line continues into the next chunk.
+        outLine.append(start, available);
+        m_bufferPosition = m_bufferSize;
+    }
+}
+
+bool LineReader::seek(u64 offset)
+{
+    if (m_file == nullptr || m_compression != Compression::None)
+        return false;
+
+    m_bufferPosition = 0;
+    m_bufferSize = 0;
+    return fseeko(m_file, static_cast<off_t>(offset), SEEK_SET) == 0;
+}
+
+bool LineReader::isOpen() const
+{
+    return m_file != nullptr;
+}
+
+bool LineReader::failed() const
+{
+    return m_failed;
+}
+
+LineReader::Compression LineReader::getCompression() const
+{
+    return m_compression;
+}
+
+LineReader::Compression LineReader::detectCompression(const std::string& fileName)
+{
+    FILE* file {fopen(fileName.c_str(), "rb")};
+
+    if (file == nullptr)
+        return Compression::None;
+
+    Compression result {::detectCompression(file)};
+    fclose(file);
+    return result;
+}
+
+bool LineReader::fill()
+{
+    m_bufferPosition = 0;
+    m_bufferSize = 0;
+
+    if (m_file == nullptr || m_failed)
+        return false;
+
+    if (m_compression == Compression::None)
+    {
+        m_bufferSize = fread(m_buffer.data(), 1, m_buffer.size(), m_file);
+        return m_bufferSize > 0;
+    }
+
+    // Keep feeding the decoder until it gives us something, since one chunk of input may not finish a block.
+    while (true)
+    {
+        if (m_inputPosition == m_inputSize && !m_inputFinished)
+        {
+            m_inputSize = fread(m_input.data(), 1, m_input.size(), m_file);
+            m_inputPosition = 0;
+            m_inputFinished = m_inputSize == 0;
+        }
+
+        bool decoded {m_compression == Compression::Gzip ? fillGzip() : fillZstd()};
+
+        if (!decoded)
+        {
+            m_failed = true;
+            return false;
+        }
+
+        if (m_bufferSize > 0)
+            return true;
+
+        if (m_inputPosition == m_inputSize && m_inputFinished)
+        {
+            if (m_frameOpen)
+            {
+                Logger::log_error("compressed input ended in the middle of a stream");
+                m_failed = true;
+            }
+
+            return false;
+        }
+    }
+}
+
+bool LineReader::fillGzip()
+{
+#ifdef ASSIG2_HAVE_ZLIB
+    auto* stream = static_cast<z_stream*>(m_decoder);
+    stream->next_in = reinterpret_cast<Bytef*>(m_input.data() + m_inputPosition);
+    stream->avail_in = static_cast<uInt>(m_inputSize - m_inputPosition);
+    stream->next_out = reinterpret_cast<Bytef*>(m_buffer.data());
+    stream->avail_out = static_cast<uInt>(m_buffer.size());
+
+    int result {inflate(stream, Z_NO_FLUSH)};
+
+    m_inputPosition = m_inputSize - stream->avail_in;
+    m_bufferSize = m_buffer.size() - stream->avail_out;
+
+    if (result == Z_STREAM_END)
+    {
+        // There may be more gzip members concatenated after this one.
+        m_frameOpen = false;
+        inflateReset(stream);
+        return true;
+    }
+
+    // A buffer error only means no progress could be made with what we had, which is fine at the end of a member.
+    if (result == Z_OK || result == Z_BUF_ERROR)
+    {
+        m_frameOpen |= result == Z_OK;
+        return true;
+    }
+
+    Logger::log_error("gzip decompression failed: %s", stream->msg != nullptr ? stream->msg : "unknown error");
+#endif
+    return false;
+}
+
+bool LineReader::fillZstd()
+{
+#ifdef ASSIG2_HAVE_ZSTD
+    ZSTD_inBuffer input {m_input.data(), m_inputSize, m_inputPosition};
+    ZSTD_outBuffer output {m_buffer.data(), m_buffer.size(), 0};
+
+    size_t result {ZSTD_decompressStream(static_cast<ZSTD_DStream*>(m_decoder), &output, &input)};
+
+    if (ZSTD_isError(result))
+    {
+        Logger::log_error("zstd decompression failed: %s", ZSTD_getErrorName(result));
+        return false;
+    }
+
+    // Zero means the current frame is complete; anything else is a hint for how much more input it expects.
+    // Between frames it always asks for more, so only listen to it once it has actually made progress.
+    if (input.pos != m_inputPosition || output.pos != 0)
+        m_frameOpen = result != 0;
+
+    m_inputPosition = input.pos;
+    m_bufferSize = output.pos;
+    return true;
+#else
+    return false;
+#endif
+}
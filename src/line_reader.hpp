@@ -0,0 +1,68 @@
+// Line-by-line file reading with transparent decompression
+
+#ifndef ASSIG2_LINE_READER_HPP
+#define ASSIG2_LINE_READER_HPP
+
+#include <cstdio>
+#include <string>
+#include <vector>
+#include "types.hpp"
+
+// Reads a file one line at a time, like std::getline. Gzip and zstd files are detected by their magic bytes and
+// decompressed a chunk at a time straight into the line buffer, so the whole file is never held in memory.
+class LineReader
+{
+public:
+    enum class Compression
+    {
+        None,
+        Gzip,
+        Zstd
+    };
+
+    explicit LineReader(const std::string& fileName);
+    ~LineReader();
+
+    LineReader(const LineReader&) = delete;
+    LineReader& operator=(const LineReader&) = delete;
+
+    // Same contract as std::getline: the newline is dropped, and false means nothing was left to read. Also false once
+    // the input has failed, even partway through a line.
+    bool getLine(std::string& outLine);
+
+    // Jumps to a byte offset in the file. Only possible for uncompressed files.
+    bool seek(u64 offset);
+
+    bool isOpen() const;
+
+    // True if the input turned out to be corrupt, or compressed in a format this build can't read.
+    bool failed() const;
+
+    Compression getCompression() const;
+
+    static Compression detectCompression(const std::string& fileName);
+
+private:
+    // Refills the line buffer with the next chunk of (decompressed) data. Returns false at the end of the input.
+    bool fill();
+    bool fillGzip();
+    bool fillZstd();
+
+    FILE* m_file;
+    Compression m_compression;
+    bool m_failed;
+    bool m_inputFinished;
+    bool m_frameOpen;   // the decoder is partway through a compressed stream, so running out of input is an error
+
+    std::vector<char> m_input;  // compressed data waiting to be decoded
+    size_t m_inputPosition;
+    size_t m_inputSize;
+
+    std::vector<char> m_buffer; // data that is ready to be split into lines
+    size_t m_bufferPosition;
+    size_t m_bufferSize;
+
+    void* m_decoder;
+};
+
+#endif // ASSIG2_LINE_READER_HPP
@@ -0,0 +1,170 @@
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <iomanip>
+#include <thread>
+#include <vector>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "logger.hpp"
+#include "listing_writer.hpp"
+
+static const size_t TAB_SIZE {12};
+static const size_t WRITE_BUFFER_SIZE {1024 * 1024};
+
+static size_t getFieldLength(const std::string& field)
+{
+    return std::max(field.size(), TAB_SIZE);
+}
+
+// Matches what write() produces with std::setw and std::left.
+static size_t getLineLength(const AssemblyLine& line)
+{
+    return getFieldLength(line.addressHex) + getFieldLength(line.label) + getFieldLength(line.instruction) +
+           getFieldLength(line.value) + getFieldLength(line.objectCode) + 1;
+}
+
+static char* renderField(const std::string& field, char* out)
+{
+    memcpy(out, field.data(), field.size());
+
+    if (field.size() < TAB_SIZE)
+        memset(out + field.size(), ' ', TAB_SIZE - field.size());
+
+    return out + getFieldLength(field);
+}
+
+static char* renderLine(const AssemblyLine& line, char* out)
+{
+    out = renderField(line.addressHex, out);
+    out = renderField(line.label, out);
+    out = renderField(line.instruction, out);
+    out = renderField(line.value, out);
+    out = renderField(line.objectCode, out);
+    *out = '\n';
+    return out + 1;
+}
+
+static bool writeAll(int file, const char* data, size_t size, u64 offset)
+{
+    while (size > 0)
+    {
+        ssize_t written {pwrite(file, data, size, static_cast<off_t>(offset))};
+
+        if (written <= 0)
+            return false;
+
+        data += written;
+        size -= static_cast<size_t>(written);
+        offset += static_cast<u64>(written);
+    }
+
+    return true;
+}
+
+bool ListingWriter::write(const std::string& fileName, const ObjectCodeData& data)
+{
+    std::ofstream outputFileStream {fileName};
+    int tabSize {static_cast<int>(TAB_SIZE)};
+
+    for (int i = 0; i < data.assemblyLineCount; ++i)
+    {
+        const AssemblyLine& cur = data.assemblyLines[i];
+
+        outputFileStream << std::setw(tabSize) << std::left << cur.addressHex
+                         << std::setw(tabSize) << std::left << cur.label
+                         << std::setw(tabSize) << std::left << cur.instruction
+                         << std::setw(tabSize) << std::left << cur.value
+                         << std::setw(tabSize) << std::left << cur.objectCode
+                         << std::endl;
+    }
+
+    return static_cast<bool>(outputFileStream);
+}
+
+bool ListingWriter::writeParallel(const std::string& fileName, const ObjectCodeData& data, unsigned threadCount)
+{
+    size_t lineCount {data.assemblyLineCount};
+    threadCount = std::max(1u, std::min(threadCount, static_cast<unsigned>(std::max<size_t>(lineCount, 1))));
+
+    // Runs work(begin, end) over an even split of the lines, one range per thread.
+    auto forEachRange = [&](const std::function<void(size_t, size_t)>& work)
+    {
+        std::vector<std::thread> threads {};
+        size_t rangeSize {(lineCount + threadCount - 1) / threadCount};
+
+        for (unsigned i {1}; i < threadCount; ++i)
+            threads.emplace_back(work, std::min(lineCount, i * rangeSize), std::min(lineCount, (i + 1) * rangeSize));
+
+        work(0, std::min(lineCount, rangeSize));
+
+        for (std::thread& thread : threads)
+            thread.join();
+    };
+
+    // Measure every line, then turn the lengths into offsets.
+    std::vector<u64> offsets(lineCount + 1);
+
+    forEachRange([&](size_t begin, size_t end)
+    {
+        for (size_t i {begin}; i < end; ++i)
+            offsets[i + 1] = getLineLength(data.assemblyLines[i]);
+    });
+
+    for (size_t i {0}; i < lineCount; ++i)
+        offsets[i + 1] += offsets[i];
+
+    int file {open(fileName.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644)};
+
+    if (file < 0)
+    {
+        Logger::log_error("could not open %s for writing", fileName.c_str());
+        return false;
+    }
+
+    if (ftruncate(file, static_cast<off_t>(offsets[lineCount])) != 0)
+    {
+        close(file);
+        return false;
+    }
+
+    std::atomic<bool> writeFailed {false};
+
+    forEachRange([&](size_t begin, size_t end)
+    {
+        // Render into a local buffer, and flush it to the line's precomputed offset whenever it fills up.
+        std::vector<char> buffer(WRITE_BUFFER_SIZE);
+        size_t used {0};
+        u64 bufferOffset {offsets[begin]};
+        bool failed {false};
+
+        for (size_t i {begin}; i < end && !failed; ++i)
+        {
+            size_t length {static_cast<size_t>(offsets[i + 1] - offsets[i])};
+
+            if (used + length > buffer.size())
+            {
+                failed |= !writeAll(file, buffer.data(), used, bufferOffset);
+                bufferOffset += used;
+                used = 0;
+
+                if (length > buffer.size())
+                    buffer.resize(length);
+            }
+
+            used = static_cast<size_t>(renderLine(data.assemblyLines[i], buffer.data() + used) - buffer.data());
+        }
+
+        failed |= !writeAll(file, buffer.data(), used, bufferOffset);
+
+        if (failed)
+            writeFailed = true;
+    });
+
+    bool closed {close(file) == 0};
+    return closed && !writeFailed;
+}
@@ -0,0 +1,20 @@
+// Listing file output
+
+#ifndef ASSIG2_LISTING_WRITER_HPP
+#define ASSIG2_LISTING_WRITER_HPP
+
+#include <string>
+#include "types.hpp"
+
+// Writes the decoded lines out as a listing, one left-aligned column per field.
+namespace ListingWriter
+{
+    bool write(const std::string& fileName, const ObjectCodeData& data);
+
+    // Produces the exact same file as write(), but on threadCount threads. Every line's length is known up front, so
+    // a prefix sum gives each line its offset, and each thread renders its own range of lines and pwrite()s them
+    // straight into the preallocated file.
+    bool writeParallel(const std::string& fileName, const ObjectCodeData& data, unsigned threadCount);
+}
+
+#endif // ASSIG2_LISTING_WRITER_HPP
@@ -4,13 +4,8 @@
 
 static const int BUFFER_LENGTH = 1000;
 
-bool Logger::enabled {true};
-
 void Logger::log_info(const char* message, ...)
 {
-    if (!enabled)
-        return;
-
     va_list list{};
     va_start(list, message);
 
@@ -23,9 +18,6 @@ void Logger::log_info(const char* message, ...)
 
 void Logger::log_warning(const char* message, ...)
 {
-    if (!enabled)
-        return;
-
     va_list list{};
     va_start(list, message);
 
@@ -38,9 +30,6 @@ void Logger::log_warning(const char* message, ...)
 
 void Logger::log_error(const char* message, ...)
 {
-    if (!enabled)
-        return;
-
     va_list list{};
     va_start(list, message);
 
@@ -12,8 +12,6 @@
 // Functions that provide a single-point of access for logging, used globally throughout the program.
 namespace Logger
 {
-    extern bool enabled;
-
     void log_info(const char* message, ...);
     void log_warning(const char* message, ...);
     void log_error(const char* message, ...);
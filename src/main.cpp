@@ -1,55 +1,304 @@
+#include <algorithm>
+#include <cstdlib>
 #include <string>
-#include <fstream>
-#include <iomanip>
-#include <iostream>
+#include <thread>
+#include <vector>
 
+#include "batch_listing.hpp"
+#include "decode_memo.hpp"
+#include "hex_decoding.hpp"
 #include "logger.hpp"
+#include "line_reader.hpp"
+#include "listing_writer.hpp"
+#include "memory_image.hpp"
 #include "types.hpp"
+#include "instruction_profile.hpp"
+#include "object_code_parser.hpp"
+#include "reverse_symbol_table.hpp"
+#include "string_parsing_tools.hpp"
+#include "symbol_table_parser.hpp"
+#include "text_record_index.hpp"
 
-bool parseSymbolTableFile(const std::string& fileName, SymbolTableData& outData);
-bool parseObjectCodeFile(const std::string& fileName, const SymbolTableData& symbolData, ObjectCodeData& outData);
+static void printUsage()
+{
+    printf("usage: ./disassem [--verbose] [--symbolic] [--memo <memo file>] [--range <start>:<end> [--index <index file>]] [--parallel-output [--jobs <n>]]\n");
+    printf("                  <object code file> <symbol table file>\n");
+    printf("       ./disassem [--verbose] [--symbolic] [--memo <memo file>] [--jobs <n>] <object code file> <symbol table file> [...more pairs]\n");
+    printf("                  (with more than one pair, each listing is written to <object code file>.lst, and with --memo a file\n");
+    printf("                   reuses records from files that finished before it started, so the first <n> files decode cold)\n");
+    printf("       ./disassem --image <image file> [--image-map <map file>] <object code file>\n");
+    printf("       ./disassem --profile [--jobs <n>] <object code file> <symbol table file> [...more pairs]\n");
+}
+
+// Parses a hex address range in the form START:END, where END is exclusive.
+static bool tryParseRange(const std::string& text, int& outStart, int& outEnd)
+{
+    size_t separator {text.find(':')};
+
+    if (separator == std::string::npos)
+        return false;
+
+    return StringParsingTools::tryGetInt(text.substr(0, separator), outStart) &&
+           StringParsingTools::tryGetInt(text.substr(separator + 1), outEnd) &&
+           outStart < outEnd;
+}
 
 int main(int argc, char* argv[])
 {
-    Logger::enabled = false;
+    std::vector<std::string> positionalArgs {};
+    bool useRange {false};
+    int rangeStart {};
+    int rangeEnd {};
+    std::string indexFile {};
+    bool useProfile {false};
+    bool useParallelOutput {false};
+    bool verbose {false};
+    bool useSymbolic {false};
+    std::string memoFile {};
+    std::string imageFile {};
+    std::string imageMapFile {};
+    unsigned jobCount {std::thread::hardware_concurrency()};
+
+    for (int i {1}; i < argc; ++i)
+    {
+        std::string arg {argv[i]};
+
+        if (arg == "--range" && i + 1 < argc)
+        {
+            useRange = true;
+
+            if (!tryParseRange(argv[++i], rangeStart, rangeEnd))
+            {
+                printf("Invalid range, expected <start>:<end> in hex!\n");
+                return -1;
+            }
+        }
+        else if (arg == "--index" && i + 1 < argc)
+        {
+            indexFile = argv[++i];
+        }
+        else if (arg == "--profile")
+        {
+            useProfile = true;
+        }
+        else if (arg == "--memo" && i + 1 < argc)
+        {
+            memoFile = argv[++i];
+        }
+        else if (arg == "--symbolic")
+        {
+            useSymbolic = true;
+        }
+        else if (arg == "--verbose")
+        {
+            verbose = true;
+        }
+        else if (arg == "--parallel-output")
+        {
+            useParallelOutput = true;
+        }
+        else if (arg == "--image" && i + 1 < argc)
+        {
+            imageFile = argv[++i];
+        }
+        else if (arg == "--image-map" && i + 1 < argc)
+        {
+            imageMapFile = argv[++i];
+        }
+        else if (arg == "--jobs" && i + 1 < argc)
+        {
+            jobCount = static_cast<unsigned>(std::max(1, atoi(argv[++i])));
+        }
+        else
+        {
+            positionalArgs.emplace_back(arg);
+        }
+    }
+
+    // Profiling takes any number of object/symbol pairs and never produces a listing.
+    if (useProfile)
+    {
+        if (positionalArgs.empty() || positionalArgs.size() % 2 != 0 || useRange)
+        {
+            printUsage();
+            return -1;
+        }
+
+        std::vector<ProfileInput> inputs {};
+
+        for (size_t i {0}; i < positionalArgs.size(); i += 2)
+            inputs.push_back({positionalArgs[i], positionalArgs[i + 1]});
+
+        InstructionProfile profile {};
+
+        if (!InstructionProfiling::profileFiles(inputs, std::max(1u, jobCount), profile))
+        {
+            printf("Failed to profile object code files!\n");
+            return -3;
+        }
+
+        InstructionProfiling::printReport(profile, stdout);
+        return 0;
+    }
+
+    // Loading a memory image only needs the object code, the symbol table is just for the listing.
+    if (!imageFile.empty())
+    {
+        if (positionalArgs.size() != 1 || useRange)
+        {
+            printUsage();
+            return -1;
+        }
+
+        MemoryImage image {};
+        std::string error {};
+
+        if (!MemoryImageLoader::load(positionalArgs[0], image, error))
+        {
+            printf("Failed to load object code file! %s\n", error.c_str());
+            return -3;
+        }
+
+        if (!MemoryImageLoader::save(imageFile, image) || (!imageMapFile.empty() && !MemoryImageLoader::saveMap(imageMapFile, image)))
+        {
+            printf("Failed to write memory image!\n");
+            return -4;
+        }
 
-    if (argc != 3)
+        return 0;
+    }
+
+    if (positionalArgs.size() < 2 || positionalArgs.size() % 2 != 0 || !imageMapFile.empty() || (!indexFile.empty() && !useRange))
     {
-        printf("usage: ./disassem <object code file> <symbol table file>\n");
+        printUsage();
         return -1;
     }
 
-    std::string objectCodeFile {argv[1]};
-    std::string symbolTableFile {argv[2]};
+    // Records seen before (i.e. in other variants of the same program) are reused instead of decoded again. Anything
+    // decoded in this run goes into a memo of its own, which is merged in once decoding is done.
+    DecodeMemo memo {};
+
+    if (!memoFile.empty() && !memo.load(memoFile))
+        printf("Ignoring unreadable memo file!\n");
+
+    // A whole corpus at once, every file on its own thread, with one listing next to each object code file.
+    if (positionalArgs.size() > 2)
+    {
+        if (useRange || useParallelOutput)
+        {
+            printUsage();
+            return -1;
+        }
+
+        std::vector<ListingInput> inputs {};
+
+        for (size_t i {0}; i < positionalArgs.size(); i += 2)
+            inputs.push_back({positionalArgs[i], positionalArgs[i + 1], positionalArgs[i] + ".lst"});
+
+        size_t previousEntryCount {memo.getEntryCount()};
+        bool listed {BatchListing::listFiles(inputs, useSymbolic, verbose, jobCount, memoFile.empty() ? nullptr : &memo)};
+
+        if (!memoFile.empty())
+        {
+            if (verbose)
+                Logger::log_info("decode memo: %llu hits, %llu misses", (unsigned long long) memo.getHitCount(), (unsigned long long) memo.getMissCount());
+
+            if (memo.getEntryCount() != previousEntryCount && !memo.save(memoFile))
+                printf("Failed to save memo file!\n");
+        }
+
+        return listed ? 0 : -3;
+    }
+
+    std::string objectCodeFile {positionalArgs[0]};
+    std::string symbolTableFile {positionalArgs[1]};
 
     SymbolTableData symbolTableData {};
-    parseSymbolTableFile(symbolTableFile, symbolTableData);
 
-    ObjectCodeData objectCodeData {};
+    if (!parseSymbolTableFile(symbolTableFile, symbolTableData))
+    {
+        printf("Failed to parse symbol table file!\n");
+        return -2;
+    }
+
+    // Built once up front, so symbolizing an operand is just a short walk down one array.
+    ReverseSymbolTable reverseSymbols {};
 
-    if (!parseObjectCodeFile(objectCodeFile, symbolTableData, objectCodeData))
+    // Only addresses inside the program get names, which takes the header. If it can't be read, parsing says why.
+    if (useSymbolic)
     {
-        printf("Failed to parse object code file!\n");
-        return -3;
+        int programStart {};
+        int programLength {};
+        parseHeaderRecord(objectCodeFile, programStart, programLength);
+        ReverseSymbolLookup::build(symbolTableData, programStart, programLength, reverseSymbols);
     }
 
-    // Output the results to a text file.
+    DecodeMemo newEntries {};
+    const DecoderContext context {&symbolTableData, verbose, useSymbolic ? &reverseSymbols : nullptr, memoFile.empty() ? nullptr : &memo};
+
+    if (verbose)
+        Logger::log_info("hex decoding: %s", HexDecoding::getImplementationName());
+
+    ObjectCodeData objectCodeData {};
+
+    if (useRange)
     {
-        std::ofstream outputFileStream {"out.lst"};
-        int tabSize{12};
+        if (LineReader::detectCompression(objectCodeFile) != LineReader::Compression::None)
+        {
+            printf("Range mode needs to seek, so the object code file can't be compressed!\n");
+            return -1;
+        }
 
-        for (int i = 0; i < objectCodeData.assemblyLineCount; ++i)
+        // Reuse the sidecar index when it matches the object file, otherwise build it and leave it for next time.
+        TextRecordIndex index {};
+
+        if (indexFile.empty() || !TextRecordIndexing::load(context, indexFile, objectCodeFile, index))
         {
-            AssemblyLine cur = objectCodeData.assemblyLines[i];
+            std::string error {};
+
+            if (!TextRecordIndexing::build(context, objectCodeFile, index, error))
+            {
+                printf("Failed to index object code file! %s\n", error.c_str());
+                return -3;
+            }
+
+            if (!indexFile.empty() && !TextRecordIndexing::save(indexFile, index))
+                printf("Failed to save index file!\n");
+        }
 
-            outputFileStream << std::setw(tabSize) << std::left << cur.addressHex
-                             << std::setw(tabSize) << std::left << cur.label
-                             << std::setw(tabSize) << std::left << cur.instruction
-                             << std::setw(tabSize) << std::left << cur.value
-                             << std::setw(tabSize) << std::left << cur.objectCode
-                             << std::endl;
+        if (!parseObjectCodeRange(context, objectCodeFile, index, rangeStart, rangeEnd, memoFile.empty() ? nullptr : &newEntries, objectCodeData))
+        {
+            printf("Failed to parse object code file! %s\n", objectCodeData.errorMessage.c_str());
+            return -3;
         }
     }
+    else if (!parseObjectCodeFile(context, objectCodeFile, memoFile.empty() ? nullptr : &newEntries, objectCodeData))
+    {
+        printf("Failed to parse object code file! %s\n", objectCodeData.errorMessage.c_str());
+        return -3;
+    }
+
+    if (!memoFile.empty())
+    {
+        size_t previousEntryCount {memo.getEntryCount()};
+        memo.merge(newEntries);
+
+        if (verbose)
+            Logger::log_info("decode memo: %llu hits, %llu misses", (unsigned long long) memo.getHitCount(), (unsigned long long) memo.getMissCount());
+
+        if (memo.getEntryCount() != previousEntryCount && !memo.save(memoFile))
+            printf("Failed to save memo file!\n");
+    }
+
+    // Output the results to a text file.
+    bool written {useParallelOutput ? ListingWriter::writeParallel("out.lst", objectCodeData, jobCount)
+                                     : ListingWriter::write("out.lst", objectCodeData)};
+
+    if (!written)
+    {
+        printf("Failed to write listing file!\n");
+        return -4;
+    }
 
     return 0;
-}
\ No newline at end of file
+}
@@ -0,0 +1,143 @@
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+
+#include "line_reader.hpp"
+#include "memory_image.hpp"
+#include "string_parsing_tools.hpp"
+#include "text_record_walker.hpp"
+
+bool MemoryImageLoader::load(const std::string& objectFileName, MemoryImage& outImage, std::string& outError)
+{
+    LineReader objectCodeReader {objectFileName};
+
+    if (!objectCodeReader.isOpen())
+    {
+        outError = "could not open " + objectFileName;
+        return false;
+    }
+
+    std::string line {};
+    TextRecord record {};
+    bool foundHeader {false};
+    bool foundEnd {false};
+    int lineNumber {};
+
+    while (objectCodeReader.getLine(line))
+    {
+        lineNumber++;
+
+        if (line.empty())
+            continue;
+
+        std::string linePrefix {"line " + std::to_string(lineNumber) + ": "};
+
+        if (line[0] == 'H')
+        {
+            if (!StringParsingTools::tryGetHexField(line, 7, 6, outImage.startAddress) ||
+                !StringParsingTools::tryGetHexField(line, 13, 6, outImage.length))
+            {
+                outError = linePrefix + "malformed header record";
+                return false;
+            }
+
+            // Names shorter than six characters are padded with spaces.
+            outImage.programName = line.substr(1, 6);
+            outImage.programName.erase(outImage.programName.find_last_not_of(' ') + 1);
+            outImage.entryPoint = outImage.startAddress;
+            outImage.bytes.assign(static_cast<size_t>(outImage.length), 0);
+            foundHeader = true;
+        }
+        else if (line[0] == 'T')
+        {
+            if (!foundHeader)
+            {
+                outError = linePrefix + "text record before the header record";
+                return false;
+            }
+
+            if (!TextRecordWalker::parse(line, record, outError))
+            {
+                outError = linePrefix + outError;
+                return false;
+            }
+
+            // Drop the bytes straight in at their address, no need to look at individual instructions.
+            int recordStart {record.startAddress - outImage.startAddress};
+
+            if (recordStart < 0 || recordStart + record.length > outImage.length)
+            {
+                outError = linePrefix + "text record at " + StringParsingTools::getHex(record.startAddress) + " falls outside the program";
+                return false;
+            }
+
+            memcpy(outImage.bytes.data() + recordStart, record.getPayload(), static_cast<size_t>(record.length));
+            outImage.initializedRanges.emplace_back(record.startAddress, record.startAddress + record.length);
+        }
+        else if (line[0] == 'E')
+        {
+            // The entry point is optional, without it execution starts at the beginning of the program.
+            if (line.size() >= 7 && !StringParsingTools::tryGetHexField(line, 1, 6, outImage.entryPoint))
+            {
+                outError = linePrefix + "malformed end record";
+                return false;
+            }
+
+            foundEnd = true;
+        }
+    }
+
+    if (objectCodeReader.failed())
+    {
+        outError = "could not read " + objectFileName;
+        return false;
+    }
+
+    if (!foundHeader || !foundEnd)
+    {
+        outError = foundHeader ? "missing end record" : "missing header record";
+        return false;
+    }
+
+    // Text records are almost always in order already, so this is cheap.
+    std::vector<std::pair<int, int>>& ranges = outImage.initializedRanges;
+    std::sort(ranges.begin(), ranges.end());
+    size_t merged {0};
+
+    for (size_t i {0}; i < ranges.size(); ++i)
+    {
+        if (merged > 0 && ranges[i].first <= ranges[merged - 1].second)
+            ranges[merged - 1].second = std::max(ranges[merged - 1].second, ranges[i].second);
+        else
+            ranges[merged++] = ranges[i];
+    }
+
+    ranges.resize(merged);
+    return true;
+}
+
+bool MemoryImageLoader::save(const std::string& imageFileName, const MemoryImage& image)
+{
+    std::ofstream imageStream {imageFileName, std::ios::binary};
+    imageStream.write(reinterpret_cast<const char*>(image.bytes.data()), static_cast<std::streamsize>(image.bytes.size()));
+    return static_cast<bool>(imageStream);
+}
+
+bool MemoryImageLoader::saveMap(const std::string& mapFileName, const MemoryImage& image)
+{
+    FILE* mapFile {fopen(mapFileName.c_str(), "w")};
+
+    if (mapFile == nullptr)
+        return false;
+
+    fprintf(mapFile, "PROGRAM %s\n", image.programName.c_str());
+    fprintf(mapFile, "START   %06X\n", image.startAddress);
+    fprintf(mapFile, "LENGTH  %06X\n", image.length);
+    fprintf(mapFile, "ENTRY   %06X\n", image.entryPoint);
+
+    for (const std::pair<int, int>& range : image.initializedRanges)
+        fprintf(mapFile, "INIT    %06X %06X\n", range.first, range.second);
+
+    return fclose(mapFile) == 0;
+}
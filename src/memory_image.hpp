@@ -0,0 +1,37 @@
+// Flat memory image loading
+
+#ifndef ASSIG2_MEMORY_IMAGE_HPP
+#define ASSIG2_MEMORY_IMAGE_HPP
+
+#include <string>
+#include <vector>
+#include "types.hpp"
+
+// The program as it would sit in memory once loaded: every text record's bytes placed at their address.
+struct MemoryImage
+{
+    std::string programName;
+    int startAddress;
+    int length;
+    int entryPoint;
+
+    // bytes[0] is startAddress. Anything no text record covers is left as zero.
+    std::vector<u8> bytes;
+
+    // The [start, end) address ranges that text records actually initialized, sorted and merged.
+    std::vector<std::pair<int, int>> initializedRanges;
+};
+
+namespace MemoryImageLoader
+{
+    // Builds the image in one pass over the H, T, and E records.
+    bool load(const std::string& objectFileName, MemoryImage& outImage, std::string& outError);
+
+    // Writes the raw bytes, nothing else.
+    bool save(const std::string& imageFileName, const MemoryImage& image);
+
+    // Writes a text sidecar with the program name, start address, length, entry point, and initialized ranges.
+    bool saveMap(const std::string& mapFileName, const MemoryImage& image);
+}
+
+#endif // ASSIG2_MEMORY_IMAGE_HPP
@@ -1,315 +1,479 @@
 #include <string>
-#include <fstream>
 #include <vector>
 
 #include "logger.hpp"
 #include "types.hpp"
+#include "line_reader.hpp"
 #include "string_parsing_tools.hpp"
 #include "instruction_definition_table.hpp"
+#include "object_code_parser.hpp"
+#include "decode_memo.hpp"
+#include "reverse_symbol_table.hpp"
+#include "text_record_walker.hpp"
+
+static const int LDB_OPCODE {0x68};
+static const int LDX_OPCODE {0x04};
 
 // Adds leading ones or zeros to a signed integer (e.g. 12bit -> 16 bit)
 int extend(int value, int bits);
 
-// Example: SVC n
-static void setValueConstant(AssemblyLine& line);
+// Everything a single parse changes as it goes. Each call to parseObjectCodeFile/parseObjectCodeRange makes its own.
+struct DecoderRun
+{
+    RegisterState registers;
+    TextRecord record; // scratch space, kept so its buffer can be reused from one text record to the next
+    std::string error;
+
+    // Only used when decoding goes through a memo.
+    DecodeMemo* newEntries;
+    DecodeMemoSymbols memoSymbols;
+    std::string memoKey;
+};
+
+static void startRun(const DecoderContext& context, DecodeMemo* newEntries, DecoderRun& run);
+
+// Reads the name, start address and length out of a header record line.
+static bool tryParseHeader(const std::string& line, std::string& outName, int& outStartAddress, int& outLength);
+
+// First pass: splits a text record into lines with their address, object code, label, and instruction.
+static bool decodeTextRecord(const DecoderContext& context, const std::string& line, DecoderRun& run, std::vector<AssemblyLine>& lines);
+
+// Decodes a text record and resolves its operands. When a memo has seen the same record before, the decoded lines are
+// copied from it instead, and only the operands that depend on the registers are resolved. Either way run.registers
+// ends up as the state after the record.
+static bool decodeAndResolve(const DecoderContext& context, const std::string& line, int followingAddress, DecoderRun& run,
+                             std::vector<AssemblyLine>& lines);
+
+// Looks up the label for an address, the last matching symbol wins.
+static std::string getLabel(const SymbolTableData& symbolData, size_t address);
+
+// Whether an operand of this shape depends on the registers coming into its record, and on where decoding continues
+// after it. Every other shape only depends on the record itself.
+static bool dependsOnRegisters(InstructionInfo::OperandShape shape);
+
+// Second pass: fills in the operand values for lines[begin, end) whose shape does (or doesn't) depend on the registers,
+// carrying the register state along. followingAddress is where decoding continues after the last line (i.e. the next
+// text record), or NO_ADDRESS.
+static void resolveValues(const DecoderContext& context, std::vector<AssemblyLine>& lines, size_t begin, size_t end, int followingAddress,
+                          RegisterState& state, bool registerDependent);
+
+// Operand kernels, one per operand shape. The shape is looked up with the opcode when a line is first decoded, so
+// resolving its value is a single jump through s_operandKernels.
+typedef void (*OperandKernel)(const DecoderContext& context, std::vector<AssemblyLine>& lines, size_t index, size_t end,
+                              int followingAddress, RegisterState& state);
+
+template<InstructionInfo::OperandShape Shape>
+static void resolveOperand(const DecoderContext& context, std::vector<AssemblyLine>& lines, size_t index, size_t end,
+                           int followingAddress, RegisterState& state);
 
-// Example: CLEAR r1
-static void setValueRegister(AssemblyLine& line);
+// The program counter is taken as the address of the next line that was decoded, which may live in the next text record.
+static size_t getProgramCounter(const std::vector<AssemblyLine>& lines, size_t index, size_t end, int followingAddress);
 
-// Example: SHIFTL r1,n
-static void setValueRegisterConstant(AssemblyLine& line);
+// Renders an address for the value column, symbolically if the context asks for it.
+static std::string getAddressOperand(const DecoderContext& context, int address);
 
-// Example: ADDR r1, r2
-static void setValueRegisterMultiple(AssemblyLine& line);
+// Applies the base-relative, PC-relative, and indexed addressing modes to an address field.
+static int getTargetAddress(const InstructionInfo::FormatThreeOrFourInfo& info, int field, int programCounter, const RegisterState& state);
 
-bool parseObjectCodeFile(const std::string& fileName, const SymbolTableData& symbolData, ObjectCodeData& outData)
+bool parseObjectCodeFile(const DecoderContext& context, const std::string& fileName, DecodeMemo* newEntries, ObjectCodeData& outData)
 {
-    auto* lines = new std::vector<AssemblyLine>;
+    std::vector<AssemblyLine>& lines = outData.lineStorage;
+    DecoderRun run {};
+    startRun(context, newEntries, run);
 
     // Header information
+    bool foundHeader {false};
     std::string headerProgramName {};
-    std::string headerStartingAddressHex {};
+    int headerStartingAddress {};
     int headerLengthBytes {};
 
-    // Do the first pass to determine header info, addressHex, object code, label, and instruction for each line.
+    // START goes first, and gets filled in once the whole file has been read.
+    lines.clear();
+    lines.emplace_back();
+
+    // Decode and resolve the text records one at a time. The PC of a record's last instruction points at wherever the
+    // next record starts, so each one is held back until the next one is read.
     {
         std::string line {};
-        std::ifstream objectCodeStream {fileName};
-        size_t currentAddress {};
+        LineReader objectCodeReader {fileName};
+        int lineNumber {};
+        std::string pendingLine {};
+        int pendingLineNumber {};
 
-        while (std::getline(objectCodeStream, line))
+        auto resolvePending = [&](int followingAddress) -> bool
         {
+            if (pendingLineNumber == 0)
+                return true;
+
+            if (!decodeAndResolve(context, pendingLine, followingAddress, run, lines))
+            {
+                outData.errorMessage = "line " + std::to_string(pendingLineNumber) + ": " + run.error;
+                return false;
+            }
+
+            pendingLineNumber = 0;
+            return true;
+        };
+
+        if (!objectCodeReader.isOpen())
+        {
+            outData.errorMessage = "could not open " + fileName;
+            return false;
+        }
+
+        while (objectCodeReader.getLine(line))
+        {
+            lineNumber++;
+
+            if (line.empty())
+                continue;
+
             if (line[0] == 'H')
             {
-                Logger::log_info("parsing header");
-                headerProgramName = line.substr(1, 6);
-                headerStartingAddressHex = line.substr(7, 6);
+                if (context.verbose)
+                    Logger::log_info("parsing header");
+
+                if (!tryParseHeader(line, headerProgramName, headerStartingAddress, headerLengthBytes))
+                {
+                    outData.errorMessage = "line " + std::to_string(lineNumber) + ": malformed header record";
+                    return false;
+                }
 
-                std::string lengthBytesHex {line.substr(13, 6)};
-                StringParsingTools::tryGetInt(lengthBytesHex, headerLengthBytes);
+                foundHeader = true;
 
-                Logger::log_info("parsed header: %s, starts at %s and has %i bytes", headerProgramName.c_str(), headerStartingAddressHex.c_str(), headerLengthBytes);
+                if (context.verbose)
+                    Logger::log_info("parsed header: %s, starts at %04X and has %i bytes", headerProgramName.c_str(), headerStartingAddress, headerLengthBytes);
             }
             else if (line[0] == 'T')
             {
-                // Decode the initial info for the text segment
-                Logger::log_info("parsing text record");
+                // A record whose address can't be read fails once it's decoded itself.
+                int startAddress {NO_ADDRESS};
+                StringParsingTools::tryGetHexField(line, 1, 6, startAddress);
 
-                std::string lengthHex {line.substr(7, 2)};
-                int lengthValue;
-                StringParsingTools::tryGetInt(lengthHex, lengthValue);
+                if (!resolvePending(startAddress))
+                    return false;
 
-                std::string startingAddressHex {line.substr(1, 6)};
-                int startingAddressValue;
-                StringParsingTools::tryGetInt(startingAddressHex, startingAddressValue);
+                pendingLine.swap(line);
+                pendingLineNumber = lineNumber;
+            }
+        }
 
-                currentAddress = startingAddressValue;
-                Logger::log_info("start: %s (%i), lengthHex: %s (%i)", startingAddressHex.c_str(), startingAddressValue, lengthHex.c_str(), lengthValue);
+        // Check this first, the last record may have been cut short.
+        if (objectCodeReader.failed())
+        {
+            outData.errorMessage = "could not read " + fileName;
+            return false;
+        }
 
-                // Now we actually loop over each instruction in the text segment
-                int index {9}; // keeps track of the current character in the line
-                size_t end = currentAddress + lengthValue;
+        if (!resolvePending(NO_ADDRESS))
+            return false;
 
-                while (currentAddress < end)
-                {
-                    AssemblyLine result {};
-                    int start {index};
-
-                    // we keep track of this info here because LDB needs that special "BASE" decoration - we append it later
-                    bool isLdb {};
-                    AssemblyLine baseInfo {};
-
-                    // check to see if current addressHex has a label
-                    for (int i {0}; i < symbolData.symbolCount; ++i)
-                    {
-                        if (currentAddress == symbolData.symbols[i].addressValue)
-                            result.label = symbolData.symbols[i].name;
-                    }
-
-                    // check to see if current addressHex is a literal
-                    bool foundLiteral {false};
-
-                    for (int i {0}; i < symbolData.literalCount; ++i)
-                    {
-                        Literal cur = symbolData.literals[i];
-
-                        if (currentAddress == cur.addressValue)
-                        {
-                            // Luckily, we can immediately decode the entire literal on the spot, no need for a second pass.
-                            result.type = AssemblyLine::Type::Literal;
-                            result.addressHex = StringParsingTools::getHex(currentAddress);
-                            result.addressValue = currentAddress;
-                            result.label = cur.name;
-                            result.instruction = "BYTE"; // todo: in reality, we shouldn't assume everything is a byte, but this is a lab
-                            result.value = cur.value;
-                            result.objectCode = StringParsingTools::getBetween(cur.value, '\'');
-                            index += cur.lengthValue;
-                            foundLiteral = true;
-                        }
-                    }
-
-                    // Only parse an instruction if we didn't have a literal
-                    if (!foundLiteral)
-                    {
-                        // Now we can assume we found an instruction to parse.
-                        std::string opCodeHex = line.substr(index, 2);
-                        index += 2;
-                        int opCodeAndNI {};
-                        StringParsingTools::tryGetInt(opCodeHex, opCodeAndNI);
-                        int opCodeValue = opCodeAndNI & 0b11111100;
-
-                        // Make sure our table contains the opcode
-                        if (!InstructionDefinitionTable::contains(opCodeValue))
-                            return false;
-
-                        InstructionDefinition instructionDefinition = InstructionDefinitionTable::get(opCodeValue);
-                        result.type = AssemblyLine::Type::Instruction;
-                        result.instruction = instructionDefinition.name;
-                        result.addressValue = currentAddress;
-                        result.instructionInfo.format = instructionDefinition.format;
-                        result.instructionInfo.opcode = opCodeValue;
-
-                        if (instructionDefinition.format == InstructionInfo::Format::Two)
-                        {
-                            index += 2;
-                        }
-                        else if (instructionDefinition.format == InstructionInfo::Format::ThreeOrFour)
-                        {
-                            // More complicated case, because the size depends on if we are extended.
-                            // Since we decode here, might as well cache all the values.
-                            InstructionInfo::FormatThreeOrFourInfo& info = result.instructionInfo.formatThreeOrFourInfo;
-                            info.n = (opCodeAndNI & 0b00000010) != 0;
-                            info.i = (opCodeAndNI & 0b00000001) != 0;
-
-                            std::string nixbpeHex {line.substr(index, 1)};
-                            index += 1;
-                            int nixbpeValue {};
-                            StringParsingTools::tryGetInt(nixbpeHex, nixbpeValue);
-
-                            info.x = (nixbpeValue & 0b1000) != 0;
-                            info.b = (nixbpeValue & 0b0100) != 0;
-                            info.p = (nixbpeValue & 0b0010) != 0;
-                            info.e = (nixbpeValue & 0b0001) != 0;
-                            index += info.e ? 5 : 3;
-
-                            // Also, we check here for the LDB outlier (and any other decorations needed in the future)
-                            if (instructionDefinition.name == "LDB")
-                            {
-                                isLdb = true;
-                                baseInfo.addressHex = "";
-                                baseInfo.label = "";
-                                baseInfo.instruction = "BASE";
-                                baseInfo.value = result.value;
-                                baseInfo.objectCode = "";
-                                baseInfo.type = AssemblyLine::Type::Decoration;
-                            }
-                        }
-
-                        // Regardless of instruction vs. literal, we always calculate objectCode and address the same.
-                        result.objectCode = line.substr(start, index - start);
-                        result.addressHex = StringParsingTools::getHex(currentAddress);
-                    }
-
-                    currentAddress += (index - start) / 2;
-                    lines->emplace_back(result);
-
-                    if (isLdb)
-                        lines->emplace_back(baseInfo);
-                }
-            }
+        if (!foundHeader)
+        {
+            outData.errorMessage = "missing header record";
+            return false;
         }
     }
 
-    // Do a second pass where we populate all the values for the instructions, and any extra decorations.
+    // Add the START and END decorations around everything.
     {
-        int startingAddressValue;
-        StringParsingTools::tryGetInt(headerStartingAddressHex, startingAddressValue);
-
-        AssemblyLine header {};
+        AssemblyLine& header = lines.front();
         header.addressHex = "0000";
         header.label = headerProgramName;
         header.instruction = "START";
-        header.value = std::to_string(startingAddressValue);
+        header.value = std::to_string(headerStartingAddress);
         header.objectCode = "";
         header.type = AssemblyLine::Type::Decoration;
-        lines->emplace(lines->begin(), header);
 
-        size_t nextAddress {};
-        int currentBase {};
-        int currentX {};
+        AssemblyLine footer {};
+        footer.addressHex = "";
+        footer.label = "";
+        footer.instruction = "END";
+        footer.value = headerProgramName;
+        footer.objectCode = "";
+        footer.type = AssemblyLine::Type::Decoration;
+        lines.emplace_back(footer);
+    }
+
+    outData.assemblyLineCount = lines.size();
+    outData.assemblyLines = lines.data();
+    return true;
+}
+
+bool parseObjectCodeRange(const DecoderContext& context, const std::string& fileName, const TextRecordIndex& index,
+                          int startAddress, int endAddress, DecodeMemo* newEntries, ObjectCodeData& outData)
+{
+    std::vector<AssemblyLine>& lines = outData.lineStorage;
+    DecoderRun run {};
+    startRun(context, newEntries, run);
+    lines.clear();
+
+    std::vector<const TextRecordIndexEntry*> entries {};
+    TextRecordIndexing::findOverlapping(index, startAddress, endAddress, entries);
+
+    if (context.verbose)
+        Logger::log_info("range %04X:%04X overlaps %i text records", startAddress, endAddress, (int) entries.size());
 
-        for (int i {0}; i < lines->size(); i++)
+    LineReader objectCodeReader {fileName};
+    std::string line {};
+    std::vector<AssemblyLine> recordLines {};
+
+    if (!objectCodeReader.isOpen())
+    {
+        outData.errorMessage = "could not open " + fileName;
+        return false;
+    }
+
+    for (const TextRecordIndexEntry* entry : entries)
+    {
+        // Jump straight to the record, and pick up the register state the index recorded for it.
+        if (!objectCodeReader.seek(entry->fileOffset) || !objectCodeReader.getLine(line) || line.empty() || line[0] != 'T')
         {
-            AssemblyLine& line = (*lines)[i];
+            outData.errorMessage = "index does not point at a text record (offset " + std::to_string(entry->fileOffset) + ")";
+            return false;
+        }
 
-            if (i < lines->size() - 1)
-                nextAddress = (*lines)[i + 1].addressValue;
+        recordLines.clear();
+        run.registers = entry->stateOnEntry;
 
-            if (line.type == AssemblyLine::Type::Instruction)
-            {
-                if (line.instructionInfo.format == InstructionInfo::Format::One)
-                {
-                    line.value = "";
-                }
-                if (line.instructionInfo.format == InstructionInfo::Format::Two)
-                {
-                    // Format 2 has a lot of annoying edge cases in their formatting - hence this conditional block
-                    if (line.instruction == "COMPR") setValueRegisterMultiple(line);
-                    if (line.instruction == "DIVR") setValueRegisterMultiple(line);
-                    if (line.instruction == "MULR") setValueRegisterMultiple(line);
-                    if (line.instruction == "SUBR") setValueRegisterMultiple(line);
-                    if (line.instruction == "ADDR") setValueRegisterMultiple(line);
-                    if (line.instruction == "TIXR") setValueRegister(line);
-                    if (line.instruction == "CLEAR") setValueRegister(line);
-                    if (line.instruction == "SHIFTL") setValueRegisterConstant(line);
-                    if (line.instruction == "SHIFTR") setValueRegisterConstant(line);
-                    if (line.instruction == "SVC") setValueConstant(line);
-                }
-                if (line.instructionInfo.format == InstructionInfo::Format::ThreeOrFour)
-                {
-                    // Format 3/4 is more consistent than 2, but a pain to calculate due to addressing modes.
+        if (!decodeAndResolve(context, line, entry->followingAddress, run, recordLines))
+        {
+            outData.errorMessage = "offset " + std::to_string(entry->fileOffset) + ": " + run.error;
+            return false;
+        }
 
-                    InstructionInfo::FormatThreeOrFourInfo& info = line.instructionInfo.formatThreeOrFourInfo;
+        // Only keep what falls inside the range - decorations (i.e. BASE) stay attached to the line before them.
+        bool keptPrevious {false};
 
-                    if (info.b) // Check if base-relative
-                    {
-                        Logger::log_info("base rel: %s", line.instruction.c_str());
-                        std::string displacementHex {line.objectCode.substr(3, 3)};
-                        int displacementValue {};
-                        StringParsingTools::tryGetInt(displacementHex, displacementValue);
+        for (const AssemblyLine& cur : recordLines)
+        {
+            bool keep {};
 
-                        if (info.x)
-                            displacementValue += currentX;
+            if (cur.type == AssemblyLine::Type::Decoration)
+                keep = keptPrevious;
+            else
+                keep = cur.addressValue >= static_cast<size_t>(startAddress) && cur.addressValue < static_cast<size_t>(endAddress);
 
-                        line.value = StringParsingTools::getHex(displacementValue + currentBase);
-                    }
-                    else if (info.p) // Check if PC-relative
-                    {
-                        Logger::log_info("pc rel: %s", line.instruction.c_str());
-                        std::string displacementHex {line.objectCode.substr(3, 3)};
-                        int displacementValue {};
-                        StringParsingTools::tryGetInt(displacementHex, displacementValue);
-                        displacementValue = extend(displacementValue, 12);
+            if (keep)
+                lines.emplace_back(cur);
 
-                        if (info.x)
-                            displacementValue += currentX;
+            keptPrevious = keep;
+        }
+    }
 
-                        line.value = StringParsingTools::getHex(displacementValue + nextAddress);
-                    }
-                    else // Then we must be direct
-                    {
-                        Logger::log_info("direct: %s", line.instruction.c_str());
-                        int length = info.e ? 5 : 3;
-                        std::string addressHex {line.objectCode.substr(3, length)};
-                        int addressValue;
-                        StringParsingTools::tryGetInt(addressHex, addressValue);
+    outData.assemblyLineCount = lines.size();
+    outData.assemblyLines = lines.data();
+    return true;
+}
 
-                        if (info.x)
-                            addressValue += currentX;
+bool parseHeaderRecord(const std::string& fileName, int& outStartAddress, int& outLength)
+{
+    LineReader objectCodeReader {fileName};
+    std::string line {};
+    std::string name {};
 
-                        line.value = StringParsingTools::getHex(addressValue);
-                    }
+    while (objectCodeReader.getLine(line))
+    {
+        if (!line.empty())
+            return line[0] == 'H' && tryParseHeader(line, name, outStartAddress, outLength);
+    }
 
-                    // These instructions do special things and have lasting effects on preceding instructions
+    return false;
+}
 
-                    if (line.instruction == "LDB")
-                        StringParsingTools::tryGetInt(line.value, currentBase);
+bool scanTextRecord(const DecoderContext& context, const TextRecord& record, int followingAddress, RegisterState& state, std::string& outError)
+{
+    // The only instructions we care about here are the ones that change how later operands resolve.
+    auto trackRegisters = [&](const WalkedInstruction& instruction) -> bool
+    {
+        if (instruction.isLiteral || (instruction.opcode != LDB_OPCODE && instruction.opcode != LDX_OPCODE))
+            return true;
 
-                    if (line.instruction == "LDX")
-                        StringParsingTools::tryGetInt(line.value, currentX);
+        int target {getTargetAddress(instruction.info, instruction.info.addressField, static_cast<int>(instruction.programCounter), state)};
 
-                    // Apply decorations
+        if (instruction.opcode == LDB_OPCODE)
+            state.base = target;
+        else
+            state.x = target;
 
-                    if (info.i && !info.n) // Immediate
-                        line.value.insert(0, "#");
+        return true;
+    };
 
-                    if (!info.i && info.n) // Indirect
-                        line.value.insert(0, "@");
-                }
+    return TextRecordWalker::walk(record, *context.symbolData, followingAddress, trackRegisters, &outError);
+}
 
-                if (line.instructionInfo.formatThreeOrFourInfo.e)
-                    line.instruction.insert(0, "+");
-            }
+static bool decodeTextRecord(const DecoderContext& context, const std::string& line, DecoderRun& run, std::vector<AssemblyLine>& lines)
+{
+    const SymbolTableData& symbolData = *context.symbolData;
+    const TextRecord& record = run.record;
+
+    // Validate and decode the initial info for the text segment
+    if (!TextRecordWalker::parse(line, run.record, run.error))
+        return false;
+
+    if (context.verbose)
+        Logger::log_info("parsing text record: start %04X, length %i", record.startAddress, record.length);
+
+    auto addLine = [&](const WalkedInstruction& instruction) -> bool
+    {
+        AssemblyLine result {};
+        result.addressHex = StringParsingTools::getHex(instruction.address);
+        result.addressValue = instruction.address;
+
+        // check to see if current addressHex has a label
+        result.label = getLabel(symbolData, instruction.address);
 
-            else if (line.instruction == "BASE")
-                line.value = StringParsingTools::getHex(currentBase);
+        if (instruction.isLiteral)
+        {
+            // Luckily, we can immediately decode the entire literal on the spot, no need for a second pass.
+            const Literal* literal {TextRecordWalker::findLiteral(symbolData, instruction.address)};
+            result.type = AssemblyLine::Type::Literal;
+            result.label = literal->name;
+            result.instruction = "BYTE"; // todo: in reality, we shouldn't assume everything is a byte, but this is a lab
+            result.value = literal->value;
+            result.objectCode = StringParsingTools::getBetween(literal->value, '\'');
+            lines.emplace_back(result);
+            return true;
         }
 
-        AssemblyLine footer {};
-        footer.addressHex = "";
-        footer.label = "";
-        footer.instruction = "END";
-        footer.value = headerProgramName;
-        footer.objectCode = "";
-        footer.type = AssemblyLine::Type::Decoration;
-        lines->emplace_back(footer);
+        const InstructionDefinition* definition {InstructionDefinitionTable::find(static_cast<u8>(instruction.opcode))};
+        result.type = AssemblyLine::Type::Instruction;
+        result.instruction = definition->name;
+        result.instructionInfo.format = instruction.format;
+        result.instructionInfo.shape = definition->shape;
+        result.instructionInfo.opcode = instruction.opcode;
+
+        // Keep the operand bits around so the second pass never has to look at the object code text again.
+        if (instruction.format == InstructionInfo::Format::Two)
+        {
+            u8 operands {record.getPayload()[instruction.payloadOffset + 1]};
+            result.instructionInfo.formatTwoInfo.r1 = static_cast<u8>(operands >> 4);
+            result.instructionInfo.formatTwoInfo.r2 = static_cast<u8>(operands & 0x0F);
+        }
+        else if (instruction.format == InstructionInfo::Format::ThreeOrFour)
+        {
+            result.instructionInfo.formatThreeOrFourInfo = instruction.info;
+        }
+
+        result.objectCode = line.substr(TEXT_RECORD_PAYLOAD_COLUMN + instruction.payloadOffset * 2, instruction.length * 2);
+        lines.emplace_back(result);
+
+        // LDB needs that special "BASE" decoration right after it (and any other decorations needed in the future)
+        if (instruction.opcode == LDB_OPCODE)
+        {
+            AssemblyLine baseInfo {};
+            baseInfo.instruction = "BASE";
+            baseInfo.type = AssemblyLine::Type::Decoration;
+            baseInfo.instructionInfo.shape = InstructionInfo::OperandShape::Base;
+            lines.emplace_back(baseInfo);
+        }
+
+        return true;
+    };
+
+    return TextRecordWalker::walk(record, symbolData, NO_ADDRESS, addLine, &run.error);
+}
+
+static void startRun(const DecoderContext& context, DecodeMemo* newEntries, DecoderRun& run)
+{
+    run.newEntries = newEntries;
+
+    if (context.memo != nullptr || newEntries != nullptr)
+        DecodeMemo::buildSymbols(*context.symbolData, run.memoSymbols);
+}
+
+static bool decodeAndResolve(const DecoderContext& context, const std::string& line, int followingAddress, DecoderRun& run,
+                             std::vector<AssemblyLine>& lines)
+{
+    bool useMemo {(context.memo != nullptr || run.newEntries != nullptr) && DecodeMemo::buildKey(line, run.memoSymbols, run.memoKey)};
+    size_t first {lines.size()};
+    bool found {false};
+
+    if (useMemo)
+    {
+        found = (context.memo != nullptr && context.memo->find(run.memoKey, lines)) || (run.newEntries != nullptr && run.newEntries->find(run.memoKey, lines));
+
+        if (run.newEntries != nullptr)
+            run.newEntries->countLookup(found);
+    }
+
+    if (!found)
+    {
+        if (!decodeTextRecord(context, line, run, lines))
+            return false;
+
+        resolveValues(context, lines, first, lines.size(), followingAddress, run.registers, false);
+
+        if (useMemo && run.newEntries != nullptr)
+            run.newEntries->insert(run.memoKey, lines.data() + first, lines.size() - first);
     }
 
-    outData.assemblyLineCount = lines->size();
-    outData.assemblyLines = lines->data();
+    resolveValues(context, lines, first, lines.size(), followingAddress, run.registers, true);
+    return true;
+}
+
+static bool tryParseHeader(const std::string& line, std::string& outName, int& outStartAddress, int& outLength)
+{
+    if (!StringParsingTools::tryGetHexField(line, 7, 6, outStartAddress) || !StringParsingTools::tryGetHexField(line, 13, 6, outLength))
+        return false;
+
+    outName = line.substr(1, 6);
     return true;
 }
 
+static std::string getLabel(const SymbolTableData& symbolData, size_t address)
+{
+    std::string result {};
+
+    for (u32 i {0}; i < symbolData.symbolCount; ++i)
+    {
+        if (address == symbolData.symbols[i].addressValue)
+            result = symbolData.symbols[i].name;
+    }
+
+    return result;
+}
+
+static size_t getProgramCounter(const std::vector<AssemblyLine>& lines, size_t index, size_t end, int followingAddress)
+{
+    for (size_t i {index + 1}; i < end; ++i)
+    {
+        if (lines[i].type != AssemblyLine::Type::Decoration)
+            return lines[i].addressValue;
+    }
+
+    // Nothing decoded after this line, so fall back to the address right after it.
+    if (followingAddress == NO_ADDRESS)
+        return lines[index].addressValue + lines[index].objectCode.size() / 2;
+
+    return followingAddress;
+}
+
+static std::string getAddressOperand(const DecoderContext& context, int address)
+{
+    if (context.reverseSymbols == nullptr)
+        return StringParsingTools::getHex(address);
+
+    return ReverseSymbolLookup::getOperand(*context.reverseSymbols, address);
+}
+
+static int getTargetAddress(const InstructionInfo::FormatThreeOrFourInfo& info, int field, int programCounter, const RegisterState& state)
+{
+    int target {};
+
+    if (info.b) // Check if base-relative
+        target = field + state.base;
+    else if (info.p) // Check if PC-relative
+        target = extend(field, 12) + programCounter;
+    else // Then we must be direct
+        target = field;
+
+    if (info.x)
+        target += state.x;
+
+    return target;
+}
+
 int extend(int value, int bits)
 {
     bits--;
@@ -336,7 +500,7 @@ int extend(int value, int bits)
 }
 
 // Table that converts the raw value for registers into readable strings.
-static std::unordered_map<int, std::string> s_registerNameMapping {
+static const std::unordered_map<int, std::string> s_registerNameMapping {
         {0, "A"},
         {1, "X"},
         {2, "L"},
@@ -348,49 +512,134 @@ static std::unordered_map<int, std::string> s_registerNameMapping {
         {9, "SW"},
 };
 
-static void setValueRegisterMultiple(AssemblyLine& line)
+// Unknown register numbers are left blank rather than guessed at.
+static std::string getRegisterName(int registerValue)
+{
+    auto result = s_registerNameMapping.find(registerValue);
+    return result != s_registerNameMapping.end() ? result->second : std::string {};
+}
+
+template<>
+void resolveOperand<InstructionInfo::OperandShape::None>(const DecoderContext&, std::vector<AssemblyLine>& lines, size_t index, size_t, int, RegisterState&)
+{
+    // Nothing to show, though RSUB can still be extended.
+    AssemblyLine& line = lines[index];
+
+    if (line.instructionInfo.format == InstructionInfo::Format::ThreeOrFour && line.instructionInfo.formatThreeOrFourInfo.e)
+        line.instruction.insert(0, "+");
+}
+
+template<>
+void resolveOperand<InstructionInfo::OperandShape::Register>(const DecoderContext&, std::vector<AssemblyLine>& lines, size_t index, size_t, int, RegisterState&)
+{
+    AssemblyLine& line = lines[index];
+    line.value = getRegisterName(line.instructionInfo.formatTwoInfo.r1);
+}
+
+template<>
+void resolveOperand<InstructionInfo::OperandShape::RegisterRegister>(const DecoderContext&, std::vector<AssemblyLine>& lines, size_t index, size_t, int, RegisterState&)
 {
-    std::string registerHex1 {line.objectCode.substr(2, 1)};
-    int registerValue1;
-    StringParsingTools::tryGetInt(registerHex1, registerValue1);
-    std::string registerName1 {s_registerNameMapping[registerValue1]};
+    AssemblyLine& line = lines[index];
+    const InstructionInfo::FormatTwoInfo& info = line.instructionInfo.formatTwoInfo;
+    line.value = getRegisterName(info.r1) + "," + getRegisterName(info.r2);
+}
 
-    std::string registerHex2 {line.objectCode.substr(3, 1)};
-    int registerValue2;
-    StringParsingTools::tryGetInt(registerHex2, registerValue2);
-    std::string registerName2 {s_registerNameMapping[registerValue2]};
+template<>
+void resolveOperand<InstructionInfo::OperandShape::RegisterConstant>(const DecoderContext&, std::vector<AssemblyLine>& lines, size_t index, size_t, int, RegisterState&)
+{
+    // Shift counts are stored as n - 1.
+    AssemblyLine& line = lines[index];
+    const InstructionInfo::FormatTwoInfo& info = line.instructionInfo.formatTwoInfo;
+    line.value = getRegisterName(info.r1) + "," + std::to_string(info.r2 + 1);
+}
 
-    line.value = registerName1 + "," + registerName2;
+template<>
+void resolveOperand<InstructionInfo::OperandShape::Constant>(const DecoderContext&, std::vector<AssemblyLine>& lines, size_t index, size_t, int, RegisterState&)
+{
+    AssemblyLine& line = lines[index];
+    line.value = std::to_string(line.instructionInfo.formatTwoInfo.r1);
 }
 
-static void setValueRegisterConstant(AssemblyLine& line)
+template<>
+void resolveOperand<InstructionInfo::OperandShape::Memory>(const DecoderContext& context, std::vector<AssemblyLine>& lines, size_t index, size_t end,
+                                                           int followingAddress, RegisterState& state)
 {
-    std::string registerHex {line.objectCode.substr(2, 1)};
-    int registerValue;
-    StringParsingTools::tryGetInt(registerHex, registerValue);
-    std::string registerName {s_registerNameMapping[registerValue]};
+    // Format 3/4 is more consistent than 2, but a pain to calculate due to addressing modes.
+    AssemblyLine& line = lines[index];
+    const InstructionInfo::FormatThreeOrFourInfo& info = line.instructionInfo.formatThreeOrFourInfo;
+
+    if (context.verbose)
+    {
+        if (info.b)
+            Logger::log_info("base rel: %s", line.instruction.c_str());
+        else if (info.p)
+            Logger::log_info("pc rel: %s", line.instruction.c_str());
+        else
+            Logger::log_info("direct: %s", line.instruction.c_str());
+    }
+
+    size_t programCounter {getProgramCounter(lines, index, end, followingAddress)};
+    int target {getTargetAddress(info, info.addressField, static_cast<int>(programCounter), state)};
+
+    // An immediate operand that wasn't relative to anything is a plain number, not an address. LDB is the exception,
+    // since its operand becomes the base that the BASE line after it names.
+    if (info.i && !info.n && !info.b && !info.p && line.instructionInfo.opcode != LDB_OPCODE)
+        line.value = StringParsingTools::getHex(target);
+    else
+        line.value = getAddressOperand(context, target);
+
+    // These instructions do special things and have lasting effects on preceding instructions
 
-    std::string constantHex {line.objectCode.substr(3, 1)};
-    int constantValue;
-    StringParsingTools::tryGetInt(constantHex, constantValue);
-    std::string constantName {std::to_string(constantValue + 1)};
+    if (line.instructionInfo.opcode == LDB_OPCODE)
+        state.base = target;
 
-    line.value = registerName + "," + constantName;
+    if (line.instructionInfo.opcode == LDX_OPCODE)
+        state.x = target;
+
+    // Apply decorations
+
+    if (info.i && !info.n) // Immediate
+        line.value.insert(0, "#");
+
+    if (!info.i && info.n) // Indirect
+        line.value.insert(0, "@");
+
+    if (info.e)
+        line.instruction.insert(0, "+");
 }
 
-static void setValueConstant(AssemblyLine& line)
+template<>
+void resolveOperand<InstructionInfo::OperandShape::Base>(const DecoderContext& context, std::vector<AssemblyLine>& lines, size_t index, size_t, int,
+                                                         RegisterState& state)
 {
-    std::string constantHex {line.objectCode.substr(2, 1)};
-    int constantValue;
-    StringParsingTools::tryGetInt(constantHex, constantValue);
-    line.value = std::to_string(constantValue);
+    lines[index].value = getAddressOperand(context, state.base);
 }
 
-static void setValueRegister(AssemblyLine& line)
+// Indexed by InstructionInfo::OperandShape.
+static const OperandKernel s_operandKernels[static_cast<int>(InstructionInfo::OperandShape::Count)] {
+        resolveOperand<InstructionInfo::OperandShape::None>,
+        resolveOperand<InstructionInfo::OperandShape::Register>,
+        resolveOperand<InstructionInfo::OperandShape::RegisterRegister>,
+        resolveOperand<InstructionInfo::OperandShape::RegisterConstant>,
+        resolveOperand<InstructionInfo::OperandShape::Constant>,
+        resolveOperand<InstructionInfo::OperandShape::Memory>,
+        resolveOperand<InstructionInfo::OperandShape::Base>,
+};
+
+static bool dependsOnRegisters(InstructionInfo::OperandShape shape)
 {
-    std::string registerHex {line.objectCode.substr(2, 1)};
-    int registerValue;
-    StringParsingTools::tryGetInt(registerHex, registerValue);
+    return shape == InstructionInfo::OperandShape::Memory || shape == InstructionInfo::OperandShape::Base;
+}
 
-    line.value = s_registerNameMapping[registerValue];
+static void resolveValues(const DecoderContext& context, std::vector<AssemblyLine>& lines, size_t begin, size_t end, int followingAddress,
+                          RegisterState& state, bool registerDependent)
+{
+    for (size_t i {begin}; i < end; i++)
+    {
+        InstructionInfo::OperandShape shape {lines[i].instructionInfo.shape};
+
+        // Literals and the START/END decorations have no shape, so the None kernel leaves them as they are.
+        if (dependsOnRegisters(shape) == registerDependent)
+            s_operandKernels[static_cast<int>(shape)](context, lines, i, end, followingAddress, state);
+    }
 }
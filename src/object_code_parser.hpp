@@ -0,0 +1,32 @@
+// Object code parsing and decoding
+
+#ifndef ASSIG2_OBJECT_CODE_PARSER_HPP
+#define ASSIG2_OBJECT_CODE_PARSER_HPP
+
+#include <string>
+#include "types.hpp"
+#include "text_record_index.hpp"
+#include "text_record_walker.hpp"
+
+// None of these keep any state between calls, so different threads can decode at the same time as long as each
+// has its own output.
+//
+// When newEntries is set, records missing from the context's memo are looked up there too, and added to it once
+// they've been decoded. Threads decoding at the same time each need their own.
+
+// Decodes every record in the file, producing a full listing including the START and END decorations.
+bool parseObjectCodeFile(const DecoderContext& context, const std::string& fileName, DecodeMemo* newEntries, ObjectCodeData& outData);
+
+// Decodes only the text records overlapping [startAddress, endAddress), using the index to seek straight to them.
+bool parseObjectCodeRange(const DecoderContext& context, const std::string& fileName, const TextRecordIndex& index,
+                          int startAddress, int endAddress, DecodeMemo* newEntries, ObjectCodeData& outData);
+
+// Reads the program's start address and length from the header record, without decoding anything else. False if the
+// file doesn't start with a readable header record.
+bool parseHeaderRecord(const std::string& fileName, int& outStartAddress, int& outLength);
+
+// Walks the instructions of a single text record without building any lines, only tracking how LDB and LDX
+// change the register state. Used to cheaply build the text record index.
+bool scanTextRecord(const DecoderContext& context, const TextRecord& record, int followingAddress, RegisterState& state, std::string& outError);
+
+#endif // ASSIG2_OBJECT_CODE_PARSER_HPP
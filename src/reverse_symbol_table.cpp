@@ -0,0 +1,99 @@
+#include <algorithm>
+
+#include "reverse_symbol_table.hpp"
+#include "string_parsing_tools.hpp"
+
+// Fills the tree with an in-order walk, which visits the nodes in sorted order. Returns the next sorted index.
+static size_t fillTree(ReverseSymbolTable& table, size_t sortedIndex, size_t node)
+{
+    if (node >= table.tree.size())
+        return sortedIndex;
+
+    sortedIndex = fillTree(table, sortedIndex, 2 * node);
+    table.tree[node] = table.addresses[sortedIndex];
+    table.ranks[node] = static_cast<u32>(sortedIndex);
+    sortedIndex++;
+    return fillTree(table, sortedIndex, 2 * node + 1);
+}
+
+void ReverseSymbolLookup::build(const SymbolTableData& symbolData, int programStart, int programLength, ReverseSymbolTable& outTable)
+{
+    std::vector<std::pair<int, const std::string*>> entries {};
+
+    for (u32 i {0}; i < symbolData.symbolCount; ++i)
+        entries.emplace_back(symbolData.symbols[i].addressValue, &symbolData.symbols[i].name);
+
+    // Stable, so the last name added for an address is the last one in its run.
+    std::stable_sort(entries.begin(), entries.end(),
+                     [](const std::pair<int, const std::string*>& a, const std::pair<int, const std::string*>& b) { return a.first < b.first; });
+
+    outTable = ReverseSymbolTable {};
+    outTable.programStart = programStart;
+    outTable.programEnd = programStart + programLength;
+
+    for (size_t i {0}; i < entries.size(); ++i)
+    {
+        if (i + 1 < entries.size() && entries[i + 1].first == entries[i].first)
+            continue;
+
+        outTable.addresses.push_back(entries[i].first);
+        outTable.names.push_back(*entries[i].second);
+    }
+
+    // The parser already sorted these, and the last one listed for an address wins.
+    for (u32 i {0}; i < symbolData.literalCount; ++i)
+    {
+        if (i + 1 < symbolData.literalCount && symbolData.literals[i + 1].addressValue == symbolData.literals[i].addressValue)
+            continue;
+
+        outTable.literalAddresses.push_back(symbolData.literals[i].addressValue);
+        outTable.literalNames.push_back(symbolData.literals[i].name);
+    }
+
+    outTable.tree.resize(outTable.addresses.size() + 1);
+    outTable.ranks.resize(outTable.addresses.size() + 1);
+    fillTree(outTable, 0, 1);
+}
+
+int ReverseSymbolLookup::find(const ReverseSymbolTable& table, int address)
+{
+    size_t size {table.tree.size()};
+    size_t node {1};
+
+    // Always goes all the way down, the comparison only picks which child.
+    while (node < size)
+        node = 2 * node + (table.tree[node] <= address ? 1 : 0);
+
+    // Undo the right turns taken after the last left turn, which lands on the first address above ours (or 0 if
+    // there is none).
+    while (node & 1)
+        node >>= 1;
+
+    node >>= 1;
+
+    size_t firstAbove {node == 0 ? table.addresses.size() : table.ranks[node]};
+    return static_cast<int>(firstAbove) - 1;
+}
+
+std::string ReverseSymbolLookup::getOperand(const ReverseSymbolTable& table, int address)
+{
+    if (address < table.programStart || address >= table.programEnd)
+        return StringParsingTools::getHex(address);
+
+    auto literal = std::lower_bound(table.literalAddresses.begin(), table.literalAddresses.end(), address);
+
+    if (literal != table.literalAddresses.end() && *literal == address)
+        return table.literalNames[literal - table.literalAddresses.begin()];
+
+    int index {find(table, address)};
+
+    if (index < 0)
+        return StringParsingTools::getHex(address);
+
+    int offset {address - table.addresses[index]};
+
+    if (offset == 0)
+        return table.names[index];
+
+    return table.names[index] + "+" + std::to_string(offset);
+}
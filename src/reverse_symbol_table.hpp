@@ -0,0 +1,47 @@
+// Address to symbol lookup for rendering operands
+
+#ifndef ASSIG2_REVERSE_SYMBOL_TABLE_HPP
+#define ASSIG2_REVERSE_SYMBOL_TABLE_HPP
+
+#include <string>
+#include <vector>
+#include "types.hpp"
+
+// Every symbol address, laid out so that finding the closest symbol at or below an address is a short, branch-free walk
+// down one array instead of a binary search jumping all over memory. Literals are kept apart, since their names only
+// ever stand for their own address.
+struct ReverseSymbolTable
+{
+    // Addresses in Eytzinger (breadth-first) order starting at index 1: the children of node k are 2k and 2k+1.
+    std::vector<int> tree;
+
+    // For each tree node, where it sits in sorted order.
+    std::vector<u32> ranks;
+
+    // Sorted by address, one name per address.
+    std::vector<int> addresses;
+    std::vector<std::string> names;
+
+    std::vector<int> literalAddresses;
+    std::vector<std::string> literalNames;
+
+    // The program's addresses, from its header record. Anything outside is left as hex.
+    int programStart;
+    int programEnd;
+};
+
+namespace ReverseSymbolLookup
+{
+    // programStart and programLength come from the header record.
+    void build(const SymbolTableData& symbolData, int programStart, int programLength, ReverseSymbolTable& outTable);
+
+    // Index into addresses/names of the closest symbol at or below address, or -1 if there isn't one.
+    int find(const ReverseSymbolTable& table, int address);
+
+    // Renders an address as a literal's name, or as SYMBOL or SYMBOL+offset (offset in decimal, like an assembler
+    // expression). Where a symbol and a literal share an address, the literal's name wins, the same as in the label
+    // column. Falls back to plain hex for addresses outside the program, or with no symbol before them.
+    std::string getOperand(const ReverseSymbolTable& table, int address);
+}
+
+#endif // ASSIG2_REVERSE_SYMBOL_TABLE_HPP
@@ -13,6 +13,35 @@ bool StringParsingTools::tryGetInt(const std::string& hex, int& outResult)
     }
 }
 
+// Reads a run of hex digits in-place, without allocating a substring.
+bool StringParsingTools::tryGetHexField(const std::string& line, size_t index, size_t count, int& outResult)
+{
+    if (index + count > line.size())
+        return false;
+
+    int result {};
+
+    for (size_t i = index; i < index + count; ++i)
+    {
+        char c {line[i]};
+        int digit;
+
+        if (c >= '0' && c <= '9')
+            digit = c - '0';
+        else if (c >= 'A' && c <= 'F')
+            digit = c - 'A' + 10;
+        else if (c >= 'a' && c <= 'f')
+            digit = c - 'a' + 10;
+        else
+            return false;
+
+        result = (result << 4) | digit;
+    }
+
+    outResult = result;
+    return true;
+}
+
 // Finds a substring within two characters.
 std::string StringParsingTools::getBetween(const std::string& value, char delimiter)
 {
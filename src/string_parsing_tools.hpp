@@ -16,6 +16,7 @@ namespace StringParsingTools
     std::string getBetween(const std::string& value, char delimiter);
     bool tryGetArg(const std::string& line, size_t index, std::string* outResult, char delimiter = ' ');
     bool tryGetInt(const std::string& hex, int& outResult);
+    bool tryGetHexField(const std::string& line, size_t index, size_t count, int& outResult);
 
     template<typename T>
     std::string getHex(T value)
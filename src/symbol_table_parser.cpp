@@ -1,24 +1,28 @@
+#include <algorithm>
 #include <string>
-#include <fstream>
 #include <vector>
 #include "types.hpp"
+#include "line_reader.hpp"
 #include "string_parsing_tools.hpp"
+#include "symbol_table_parser.hpp"
 
-// Extracts symbol and literal information from a symbol table file.
 bool parseSymbolTableFile(const std::string& fileName, SymbolTableData& outData)
 {
-    std::ifstream symbolFileStream {fileName};
+    LineReader symbolFileReader {fileName};
     std::string line {};
 
+    if (!symbolFileReader.isOpen())
+        return false;
+
     // Extract all symbols
     {
         auto* symbols = new std::vector<Symbol>();
 
         // Skip the header
-        std::getline(symbolFileStream, line);
-        std::getline(symbolFileStream, line);
+        symbolFileReader.getLine(line);
+        symbolFileReader.getLine(line);
 
-        while (std::getline(symbolFileStream, line))
+        while (symbolFileReader.getLine(line))
         {
             bool failure {false};
 
@@ -43,10 +47,10 @@ bool parseSymbolTableFile(const std::string& fileName, SymbolTableData& outData)
         auto* literals = new std::vector<Literal>();
 
         // Skip the header
-        std::getline(symbolFileStream, line);
-        std::getline(symbolFileStream, line);
+        symbolFileReader.getLine(line);
+        symbolFileReader.getLine(line);
 
-        while (std::getline(symbolFileStream, line))
+        while (symbolFileReader.getLine(line))
         {
             bool failure {false};
 
@@ -64,9 +68,13 @@ bool parseSymbolTableFile(const std::string& fileName, SymbolTableData& outData)
             literals->emplace_back(literal);
         }
 
+        // Sorted so a literal can be found with a binary search. Stable, so literals sharing an address keep their
+        // order and the last one listed still wins.
+        std::stable_sort(literals->begin(), literals->end(), [](const Literal& a, const Literal& b) { return a.addressValue < b.addressValue; });
+
         outData.literalCount = literals->size();
         outData.literals = literals->data();
     }
 
-    return true;
+    return !symbolFileReader.failed();
 }
@@ -0,0 +1,13 @@
+// Symbol table parsing
+
+#ifndef ASSIG2_SYMBOL_TABLE_PARSER_HPP
+#define ASSIG2_SYMBOL_TABLE_PARSER_HPP
+
+#include <string>
+#include "types.hpp"
+
+// Extracts symbol and literal information from a symbol table file. False if the file can't be opened or read to the
+// end, in which case outData holds whatever was read before that.
+bool parseSymbolTableFile(const std::string& fileName, SymbolTableData& outData);
+
+#endif // ASSIG2_SYMBOL_TABLE_PARSER_HPP
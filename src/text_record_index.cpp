@@ -0,0 +1,230 @@
+#include <algorithm>
+#include <fstream>
+#include <string>
+#include <sys/stat.h>
+
+#include "logger.hpp"
+#include "hashing.hpp"
+#include "line_reader.hpp"
+#include "object_code_parser.hpp"
+#include "text_record_index.hpp"
+
+static const char* INDEX_FILE_TAG {"TRINDEX2"};
+
+// The shortest a text record line can be: 'T', the address and length, and the newline.
+static const u64 MIN_TEXT_RECORD_LINE_SIZE {TEXT_RECORD_PAYLOAD_COLUMN + 1};
+
+// Size and modification time of a file, or zeros if it can't be stat'ed.
+static void getFileStamp(const std::string& fileName, u64& outSize, s64& outModified)
+{
+    struct stat status {};
+
+    if (stat(fileName.c_str(), &status) != 0)
+    {
+        outSize = 0;
+        outModified = 0;
+        return;
+    }
+
+#ifdef __APPLE__
+    const timespec& modified = status.st_mtimespec;
+#else
+    const timespec& modified = status.st_mtim;
+#endif
+
+    outSize = static_cast<u64>(status.st_size);
+    outModified = static_cast<s64>(modified.tv_sec) * 1000000000 + modified.tv_nsec;
+}
+
+// Sorts the entries by start address and computes the running maximum end address used to bound queries.
+static void finalize(TextRecordIndex& index)
+{
+    std::stable_sort(index.entries.begin(), index.entries.end(),
+                     [](const TextRecordIndexEntry& a, const TextRecordIndexEntry& b) { return a.startAddress < b.startAddress; });
+
+    index.maxEndAddress.resize(index.entries.size());
+    int maxEnd {0};
+
+    for (size_t i {0}; i < index.entries.size(); ++i)
+    {
+        maxEnd = std::max(maxEnd, index.entries[i].startAddress + index.entries[i].length);
+        index.maxEndAddress[i] = maxEnd;
+    }
+}
+
+// Builds the index in a single pass over the file. Text records are only walked far enough to follow LDB and LDX,
+// nothing gets turned into lines or strings. Each record is held back until the next one is seen, since the last
+// instruction of a record resolves against the start of the following record.
+bool TextRecordIndexing::build(const DecoderContext& context, const std::string& objectFileName, TextRecordIndex& outIndex, std::string& outError)
+{
+    // Offsets are only meaningful if we can seek back to them later.
+    LineReader objectCodeReader {objectFileName};
+
+    if (!objectCodeReader.isOpen() || objectCodeReader.getCompression() != LineReader::Compression::None)
+    {
+        outError = "could not open " + objectFileName + " uncompressed";
+        return false;
+    }
+
+    std::string line {};
+    TextRecord record {};
+    TextRecord pendingRecord {};
+    bool hasPendingRecord {false};
+    u64 offset {};
+    RegisterState state {};
+    outIndex.entries.clear();
+
+    // Finishes the record that was held back, now that we know what follows it.
+    auto scanPending = [&](int followingAddress) -> bool
+    {
+        if (!hasPendingRecord)
+            return true;
+
+        TextRecordIndexEntry& entry = outIndex.entries.back();
+        entry.followingAddress = followingAddress;
+        entry.stateOnEntry = state;
+
+        if (!scanTextRecord(context, pendingRecord, followingAddress, state, outError))
+        {
+            outError = "offset " + std::to_string(entry.fileOffset) + ": " + outError;
+            return false;
+        }
+
+        hasPendingRecord = false;
+        return true;
+    };
+
+    while (objectCodeReader.getLine(line))
+    {
+        if (!line.empty() && line[0] == 'T')
+        {
+            if (!TextRecordWalker::parse(line, record, outError))
+            {
+                outError = "offset " + std::to_string(offset) + ": " + outError;
+                return false;
+            }
+
+            if (!scanPending(record.startAddress))
+                return false;
+
+            TextRecordIndexEntry entry {};
+            entry.fileOffset = offset;
+            entry.startAddress = record.startAddress;
+            entry.length = record.length;
+            outIndex.entries.emplace_back(entry);
+
+            pendingRecord.bytes.swap(record.bytes);
+            pendingRecord.startAddress = record.startAddress;
+            pendingRecord.length = record.length;
+            hasPendingRecord = true;
+        }
+
+        // getline drops the newline, so add it back to stay in sync with the real file offsets.
+        offset += line.size() + 1;
+    }
+
+    if (!scanPending(NO_ADDRESS))
+        return false;
+
+    getFileStamp(objectFileName, outIndex.objectFileSize, outIndex.objectFileModified);
+    outIndex.symbolTableHash = Hashing::hashSymbolTable(*context.symbolData);
+    finalize(outIndex);
+    return true;
+}
+
+bool TextRecordIndexing::load(const DecoderContext& context, const std::string& indexFileName, const std::string& objectFileName, TextRecordIndex& outIndex)
+{
+    std::ifstream indexStream {indexFileName};
+
+    if (!indexStream)
+        return false;
+
+    std::string tag {};
+    size_t entryCount {};
+    indexStream >> tag >> outIndex.objectFileSize >> outIndex.objectFileModified >> outIndex.symbolTableHash >> entryCount;
+
+    if (!indexStream || tag != INDEX_FILE_TAG)
+    {
+        Logger::log_warning("%s is not a text record index", indexFileName.c_str());
+        return false;
+    }
+
+    u64 objectFileSize {};
+    s64 objectFileModified {};
+    getFileStamp(objectFileName, objectFileSize, objectFileModified);
+
+    if (outIndex.objectFileSize != objectFileSize || outIndex.objectFileModified != objectFileModified ||
+        outIndex.symbolTableHash != Hashing::hashSymbolTable(*context.symbolData))
+    {
+        Logger::log_warning("%s is stale for %s", indexFileName.c_str(), objectFileName.c_str());
+        return false;
+    }
+
+    // Every text record takes at least a line of its own, so a count the object file has no room for means the index
+    // was damaged rather than built for this file.
+    if (entryCount > objectFileSize / MIN_TEXT_RECORD_LINE_SIZE)
+    {
+        Logger::log_warning("%s is stale for %s", indexFileName.c_str(), objectFileName.c_str());
+        return false;
+    }
+
+    outIndex.entries.resize(entryCount);
+
+    for (TextRecordIndexEntry& entry : outIndex.entries)
+    {
+        indexStream >> entry.fileOffset >> entry.startAddress >> entry.length >> entry.followingAddress
+                    >> entry.stateOnEntry.base >> entry.stateOnEntry.x;
+    }
+
+    if (!indexStream)
+    {
+        Logger::log_warning("%s is stale for %s", indexFileName.c_str(), objectFileName.c_str());
+        return false;
+    }
+
+    finalize(outIndex);
+    return true;
+}
+
+bool TextRecordIndexing::save(const std::string& indexFileName, const TextRecordIndex& index)
+{
+    std::ofstream indexStream {indexFileName};
+
+    if (!indexStream)
+        return false;
+
+    indexStream << INDEX_FILE_TAG << ' ' << index.objectFileSize << ' ' << index.objectFileModified << ' ' << index.symbolTableHash << ' '
+                << index.entries.size() << '\n';
+
+    for (const TextRecordIndexEntry& entry : index.entries)
+    {
+        indexStream << entry.fileOffset << ' ' << entry.startAddress << ' ' << entry.length << ' ' << entry.followingAddress << ' '
+                    << entry.stateOnEntry.base << ' ' << entry.stateOnEntry.x << '\n';
+    }
+
+    return static_cast<bool>(indexStream);
+}
+
+void TextRecordIndexing::findOverlapping(const TextRecordIndex& index, int startAddress, int endAddress,
+                                         std::vector<const TextRecordIndexEntry*>& outEntries)
+{
+    outEntries.clear();
+
+    // Everything from here on starts at or after the end of the range, so it can't overlap.
+    auto last = std::lower_bound(index.entries.begin(), index.entries.end(), endAddress,
+                                 [](const TextRecordIndexEntry& entry, int address) { return entry.startAddress < address; });
+
+    // Walk backwards until no earlier record can reach into the range anymore.
+    for (size_t i = last - index.entries.begin(); i > 0; --i)
+    {
+        if (index.maxEndAddress[i - 1] <= startAddress)
+            break;
+
+        const TextRecordIndexEntry& entry = index.entries[i - 1];
+
+        if (entry.startAddress + entry.length > startAddress)
+            outEntries.emplace_back(&entry);
+    }
+
+    std::reverse(outEntries.begin(), outEntries.end());
+}
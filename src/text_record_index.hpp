@@ -0,0 +1,47 @@
+// Interval index over the text records of an object code file
+
+#ifndef ASSIG2_TEXT_RECORD_INDEX_HPP
+#define ASSIG2_TEXT_RECORD_INDEX_HPP
+
+#include <string>
+#include <vector>
+#include "types.hpp"
+
+// Where a text record lives in the file, which addresses it covers, and the register state in effect when
+// execution reaches it. The register state lets a record be decoded on its own, without the records before it.
+struct TextRecordIndexEntry
+{
+    u64 fileOffset;
+    int startAddress;
+    int length;
+    int followingAddress; // start of the next text record in the file, or NO_ADDRESS
+    RegisterState stateOnEntry;
+};
+
+struct TextRecordIndex
+{
+    // Which version of the object file and symbol table the index was built from. The object file is only stat'ed,
+    // so checking an index never means reading the whole file; the symbol table is hashed, since literals change
+    // how records are walked and therefore the register state stored for each one.
+    u64 objectFileSize;
+    s64 objectFileModified; // nanoseconds since the epoch
+    u64 symbolTableHash;
+
+    // Sorted by start address, with the running maximum end address so overlapping queries can stop early.
+    std::vector<TextRecordIndexEntry> entries;
+    std::vector<int> maxEndAddress;
+};
+
+namespace TextRecordIndexing
+{
+    bool build(const DecoderContext& context, const std::string& objectFileName, TextRecordIndex& outIndex, std::string& outError);
+    // Refuses an index built for a different version of the object file or symbol table.
+    bool load(const DecoderContext& context, const std::string& indexFileName, const std::string& objectFileName, TextRecordIndex& outIndex);
+    bool save(const std::string& indexFileName, const TextRecordIndex& index);
+
+    // Collects the entries overlapping [startAddress, endAddress), in order of start address.
+    void findOverlapping(const TextRecordIndex& index, int startAddress, int endAddress,
+                         std::vector<const TextRecordIndexEntry*>& outEntries);
+}
+
+#endif // ASSIG2_TEXT_RECORD_INDEX_HPP
@@ -0,0 +1,61 @@
+#include <cstdio>
+
+#include "hex_decoding.hpp"
+#include "text_record_walker.hpp"
+
+static std::string describeCharacter(char c)
+{
+    char buffer[16];
+
+    if (c >= 0x20 && c < 0x7F)
+        snprintf(buffer, sizeof(buffer), "'%c'", c);
+    else
+        snprintf(buffer, sizeof(buffer), "0x%02X", static_cast<u8>(c));
+
+    return buffer;
+}
+
+bool TextRecordWalker::parse(const std::string& line, TextRecord& outRecord, std::string& outError)
+{
+    // Trailing whitespace (i.e. a CR from a windows line ending) isn't part of the record.
+    size_t end {line.size()};
+
+    while (end > 1 && (line[end - 1] == '\r' || line[end - 1] == ' ' || line[end - 1] == '\t'))
+        end--;
+
+    size_t hexLength {end - 1};
+
+    if (line.empty() || line[0] != 'T' || hexLength < TEXT_RECORD_PAYLOAD_COLUMN - 1)
+    {
+        outError = "text record is too short to have an address and length";
+        return false;
+    }
+
+    // Validate and convert the whole record at once, header included.
+    outRecord.bytes.resize(hexLength / 2);
+    size_t badIndex {HexDecoding::decode(line.data() + 1, hexLength & ~static_cast<size_t>(1), outRecord.bytes.data())};
+
+    if (badIndex != HexDecoding::ALL_VALID)
+    {
+        outError = "invalid hex character " + describeCharacter(line[badIndex + 1]) + " at column " + std::to_string(badIndex + 2);
+        return false;
+    }
+
+    if (hexLength % 2 != 0)
+    {
+        outError = "dangling hex digit at column " + std::to_string(end);
+        return false;
+    }
+
+    const u8* header {outRecord.bytes.data()};
+    outRecord.startAddress = (header[0] << 16) | (header[1] << 8) | header[2];
+    outRecord.length = header[3];
+
+    if (outRecord.getPayloadSize() < static_cast<size_t>(outRecord.length))
+    {
+        outError = "text record has " + std::to_string(outRecord.getPayloadSize()) + " bytes of object code but claims " + std::to_string(outRecord.length);
+        return false;
+    }
+
+    return true;
+}
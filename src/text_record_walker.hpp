@@ -0,0 +1,195 @@
+// Lightweight walk over the instructions of a text record
+
+#ifndef ASSIG2_TEXT_RECORD_WALKER_HPP
+#define ASSIG2_TEXT_RECORD_WALKER_HPP
+
+#include <algorithm>
+#include <string>
+#include <vector>
+#include "types.hpp"
+#include "string_parsing_tools.hpp"
+#include "instruction_definition_table.hpp"
+
+// Where the object code starts in a text record line: 'T', 6 characters of address, 2 of length.
+static const size_t TEXT_RECORD_PAYLOAD_COLUMN {9};
+
+// A text record line that has been validated and converted from hex to bytes in one go.
+struct TextRecord
+{
+    int startAddress;
+    int length;
+    std::vector<u8> bytes; // everything after the 'T', so the address and length bytes come first
+
+    const u8* getPayload() const
+    {
+        return bytes.data() + 4;
+    }
+
+    size_t getPayloadSize() const
+    {
+        return bytes.size() - 4;
+    }
+};
+
+// One instruction (or literal) found by the walker. Nothing is rendered to text, so this is cheap enough to
+// produce for every instruction in a large file.
+struct WalkedInstruction
+{
+    bool isLiteral;
+    size_t address;
+    size_t programCounter;  // address of whatever gets decoded next
+    size_t payloadOffset;   // byte in the record's payload where the object code starts
+    size_t length;          // in bytes
+
+    // Only valid for instructions.
+    int opcode;
+    InstructionInfo::Format format;
+
+    // Only valid for format 3/4: the six addressing bits packed as nixbpe (n = 0b100000), and the same bits unpacked
+    // along with the address field.
+    int nixbpe;
+    InstructionInfo::FormatThreeOrFourInfo info;
+};
+
+namespace TextRecordWalker
+{
+    // Checks every character of the line and decodes it into outRecord. On failure, outError says what was wrong,
+    // including the column of the first bad character.
+    bool parse(const std::string& line, TextRecord& outRecord, std::string& outError);
+
+    // The literal placed at address, if any. Relies on the symbol table parser leaving literals sorted by address;
+    // when several share an address, the last one listed wins.
+    inline const Literal* findLiteral(const SymbolTableData& symbolData, size_t address)
+    {
+        const Literal* begin {symbolData.literals};
+        const Literal* end {begin + symbolData.literalCount};
+        int target {static_cast<int>(address)};
+        const Literal* next {std::upper_bound(begin, end, target, [](int value, const Literal& literal) { return value < literal.addressValue; })};
+
+        if (next == begin || (next - 1)->addressValue != target)
+            return nullptr;
+
+        return next - 1;
+    }
+
+    // The displacement or address of a format 3/4 instruction. Relative modes only ever use a 12-bit
+    // displacement, direct addressing uses the whole field.
+    inline int getAddressField(const TextRecord& record, const WalkedInstruction& instruction)
+    {
+        const u8* objectCode {record.getPayload() + instruction.payloadOffset};
+        int field {((objectCode[1] & 0x0F) << 8) | objectCode[2]};
+
+        if (instruction.info.e && !instruction.info.b && !instruction.info.p)
+            field = (field << 8) | objectCode[3];
+
+        return field;
+    }
+
+    // Calls visitor(const WalkedInstruction&) for every instruction and literal in the record, stopping early if
+    // the visitor returns false. followingAddress is the start of the next text record, or NO_ADDRESS.
+    template<typename Visitor>
+    bool walk(const TextRecord& record, const SymbolTableData& symbolData, int followingAddress, Visitor& visitor, std::string* outError = nullptr)
+    {
+        const u8* payload {record.getPayload()};
+        size_t payloadSize {record.getPayloadSize()};
+        size_t currentAddress = record.startAddress;
+        size_t end = currentAddress + record.length;
+        size_t offset {0};
+
+        while (currentAddress < end)
+        {
+            WalkedInstruction result {};
+            result.address = currentAddress;
+            result.payloadOffset = offset;
+
+            const Literal* literal {findLiteral(symbolData, currentAddress)};
+
+            if (literal != nullptr)
+            {
+                // The literal's length is counted in hex characters.
+                result.isLiteral = true;
+                offset += literal->lengthValue / 2;
+            }
+            else
+            {
+                if (offset >= payloadSize)
+                {
+                    if (outError != nullptr)
+                        *outError = "text record ends in the middle of an instruction";
+
+                    return false;
+                }
+
+                int opCodeAndNI {payload[offset]};
+                result.opcode = opCodeAndNI & 0b11111100;
+
+                const InstructionDefinition* definition {InstructionDefinitionTable::find(static_cast<u8>(result.opcode))};
+
+                if (definition == nullptr)
+                {
+                    if (outError != nullptr)
+                        *outError = "unknown opcode " + StringParsingTools::getHex(result.opcode).substr(2) + " at address " + StringParsingTools::getHex(currentAddress);
+
+                    return false;
+                }
+
+                result.format = definition->format;
+                size_t size {1};
+
+                if (result.format == InstructionInfo::Format::Two)
+                {
+                    size = 2;
+                }
+                else if (result.format == InstructionInfo::Format::ThreeOrFour)
+                {
+                    size = 3;
+
+                    // The e flag decides between format 3 and 4, as long as there's a byte to read it from.
+                    if (offset + 1 < payloadSize)
+                    {
+                        int nixbpeValue {payload[offset + 1] >> 4};
+                        result.nixbpe = ((opCodeAndNI & 0b11) << 4) | nixbpeValue;
+
+                        InstructionInfo::FormatThreeOrFourInfo& info = result.info;
+                        info.n = (opCodeAndNI & 0b00000010) != 0;
+                        info.i = (opCodeAndNI & 0b00000001) != 0;
+                        info.x = (nixbpeValue & 0b1000) != 0;
+                        info.b = (nixbpeValue & 0b0100) != 0;
+                        info.p = (nixbpeValue & 0b0010) != 0;
+                        info.e = (nixbpeValue & 0b0001) != 0;
+                        size = info.e ? 4 : 3;
+                    }
+                }
+
+                if (offset + size > payloadSize)
+                {
+                    if (outError != nullptr)
+                        *outError = "text record ends in the middle of an instruction";
+
+                    return false;
+                }
+
+                if (result.format == InstructionInfo::Format::ThreeOrFour)
+                    result.info.addressField = getAddressField(record, result);
+
+                offset += size;
+            }
+
+            result.length = offset - result.payloadOffset;
+            currentAddress += result.length;
+
+            // Matches how listings resolve operands: the last instruction of a record sees the next record's address.
+            result.programCounter = currentAddress;
+
+            if (currentAddress >= end && followingAddress != NO_ADDRESS)
+                result.programCounter = followingAddress;
+
+            if (!visitor(result))
+                return false;
+        }
+
+        return true;
+    }
+}
+
+#endif // ASSIG2_TEXT_RECORD_WALKER_HPP
@@ -7,6 +7,8 @@
 #define ASSIG2_TYPES_H
 
 #include <cstdint>
+#include <string>
+#include <vector>
 
 // Basic types
 typedef uint8_t u8;
@@ -15,6 +17,8 @@ typedef uint16_t u16;
 typedef int16_t s16;
 typedef uint32_t u32;
 typedef int32_t s32;
+typedef uint64_t u64;
+typedef int64_t s64;
 
 // A structured representation of an SIC/XC instruction.
 // Uses a tagged union to potentially better represent different formats in the future, and clarify
@@ -28,21 +32,38 @@ struct InstructionInfo
         ThreeOrFour
     };
 
+    // What the operand looks like, which decides how the value column is rendered.
+    enum class OperandShape
+    {
+        None,               // e.g. FIX or RSUB
+        Register,           // e.g. CLEAR r1
+        RegisterRegister,   // e.g. ADDR r1,r2
+        RegisterConstant,   // e.g. SHIFTL r1,n
+        Constant,           // e.g. SVC n
+        Memory,             // any other format 3/4 instruction
+        Base,               // the BASE decoration after LDB, which names the base register's value
+        Count
+    };
+
     struct FormatOneInfo
     {
         // Empty for now
     };
     struct FormatTwoInfo
     {
-        // Empty for now
+        u8 r1, r2; // the two nibbles of the second byte
     };
     struct FormatThreeOrFourInfo
     {
         // todo: this could save a lot of memory by leaving this as a single byte and decoding when needed
         bool n, i, x, b, p, e;
+
+        // The displacement (12 bits) or, for format 4 direct addressing, the whole 20-bit address.
+        int addressField;
     };
 
     Format format;
+    OperandShape shape;
     int opcode;
 
     // Data that may be unique to a certain instruction format.
@@ -54,6 +75,16 @@ struct InstructionInfo
     };
 };
 
+// The registers that change how later operands are resolved (base-relative and indexed addressing).
+struct RegisterState
+{
+    int base;
+    int x;
+};
+
+// Marks an address that isn't known, e.g. what follows the last text record.
+static const int NO_ADDRESS {-1};
+
 struct Symbol
 {
     std::string name;
@@ -78,7 +109,24 @@ struct SymbolTableData
     Symbol* symbols;
 
     u32 literalCount;
-    Literal* literals;
+    Literal* literals; // sorted by address
+};
+
+struct ReverseSymbolTable;
+class DecodeMemo;
+
+// Everything decoding reads but never changes. One context can be shared by any number of threads decoding at the
+// same time, since each decode keeps its own register state and output.
+struct DecoderContext
+{
+    const SymbolTableData* symbolData;
+    bool verbose; // log progress through Logger::log_info
+
+    // When set, operand addresses are rendered as SYMBOL or SYMBOL+offset instead of hex.
+    const ReverseSymbolTable* reverseSymbols;
+
+    // When set, text records that were decoded before are copied from here instead. Only ever read while decoding.
+    const DecodeMemo* memo;
 };
 
 struct AssemblyLine
@@ -105,6 +153,10 @@ struct ObjectCodeData
 {
     u32 assemblyLineCount;
     AssemblyLine* assemblyLines;
+    std::vector<AssemblyLine> lineStorage; // what assemblyLines points into
+
+    // Set when parsing fails, saying where and why.
+    std::string errorMessage;
 };
 
 #endif // ASSIG2_TYPES_H
@@ -0,0 +1,58 @@
+#!/bin/sh
+# Runs every sample through the disassembler once per hex decoding kernel, and compares the result with what the
+# sample expects: stdout.txt for samples that should be rejected or that print a report, otherwise out.lst. Extra
+# arguments for a sample go in args.txt. Those samples' listings came from this disassembler, so they have to match
+# byte for byte; the original samples use narrower columns, so theirs are compared with runs of spaces collapsed.
+# Files those arguments name (an index or a memo) are kept from one kernel to the next, so the first run of a sample
+# creates them and the other two reuse them.
+#
+# usage: ./check_samples.sh <path to disassem>
+
+if [ $# -ne 1 ]; then
+    echo "usage: $0 <path to disassem>"
+    exit 1
+fi
+
+disassem="$(cd "$(dirname "$1")" && pwd)/$(basename "$1")"
+samples="$(cd "$(dirname "$0")" && pwd)"
+work="$(mktemp -d)"
+trap 'rm -rf "$work"' EXIT
+failures=0
+
+for dir in "$samples"/*/; do
+    name="$(basename "$dir")"
+    args=""
+
+    if [ -f "$dir/args.txt" ]; then
+        args="$(cat "$dir/args.txt")"
+    fi
+
+    rm -f "$work"/*
+
+    for kernel in scalar sse2 avx2; do
+        rm -f "$work/out.lst"
+        (cd "$work" && ASSIG2_HEX_DECODER=$kernel "$disassem" $args "$dir/test.obj" "$dir/test.sym" > "$work/stdout.txt")
+
+        if [ -f "$dir/stdout.txt" ]; then
+            cmp -s "$dir/stdout.txt" "$work/stdout.txt"
+        elif [ -f "$dir/args.txt" ]; then
+            cmp -s "$dir/out.lst" "$work/out.lst"
+        else
+            tr -s ' ' < "$dir/out.lst" | sed 's/ *$//' > "$work/expected.lst"
+            tr -s ' ' < "$work/out.lst" | sed 's/ *$//' > "$work/actual.lst"
+            cmp -s "$work/expected.lst" "$work/actual.lst"
+        fi
+
+        if [ $? -ne 0 ]; then
+            echo "FAIL: $name ($kernel)"
+            failures=$((failures + 1))
+        fi
+    done
+done
+
+if [ $failures -ne 0 ]; then
+    echo "$failures failed"
+    exit 1
+fi
+
+echo "all samples passed"